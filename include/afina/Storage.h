@@ -1,7 +1,10 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstddef>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 
@@ -84,6 +87,14 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) = 0;
+
+    /**
+     * Appends storage counters to the given output parameter as name/value pairs, they
+     * are reported to clients by "stats" command
+     *
+     * @param stats output parameter to append counters to
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::size_t>> &) const {}
 };
 
 } // namespace Afina
@@ -0,0 +1,82 @@
+#ifndef AFINA_ALLOCATOR_DEFRAGMENTER_H
+#define AFINA_ALLOCATOR_DEFRAGMENTER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace Afina {
+namespace Allocator {
+
+// Forward declaration. Do not include real class definition
+// to avoid expensive macros calculations and increase compile speed
+class Simple;
+
+/**
+ * # Incremental defragmentation
+ * Spreads Simple::defrag() over time instead of compacting whole area at once. Each step moves blocks
+ * one by one until max_pause is spent. The lock shared with allocator users is taken for every block
+ * separately, so no one waits for compaction longer than a single block move.
+ *
+ * Allocator users must hold the same lock while calling allocator and while working with raw addresses
+ * returned by Pointer::get(), because blocks could be moved by any step.
+ *
+ * Steps could be driven by background thread (see Start/Stop) or piggybacked on idle cycles of
+ * existing threads by calling Step() directly
+ */
+class Defragmenter {
+public:
+    Defragmenter(Simple &allocator, std::mutex &lock,
+                 std::chrono::microseconds max_pause = std::chrono::microseconds(200),
+                 std::chrono::microseconds interval = std::chrono::microseconds(1000));
+    ~Defragmenter();
+
+    /**
+     * Spawns background thread that performs one step each interval
+     */
+    void Start();
+
+    /**
+     * Stops background thread, blocks until it is done
+     */
+    void Stop();
+
+    /**
+     * Performs single bounded step of defragmentation. Returns true if there is more work to do
+     */
+    bool Step();
+
+    /**
+     * Longest time the lock has been held by a step so far
+     */
+    std::chrono::microseconds longest_pause() const;
+
+private:
+    Defragmenter(const Defragmenter &) = delete;
+    Defragmenter &operator=(const Defragmenter &) = delete;
+
+    void OnRun();
+
+    Simple &_allocator;
+
+    // Lock shared with allocator users
+    std::mutex &_lock;
+
+    const std::chrono::microseconds _max_pause;
+    const std::chrono::microseconds _interval;
+
+    // Protects state below
+    mutable std::mutex _mutex;
+    std::condition_variable _stop_condition;
+    bool _running;
+    std::chrono::microseconds _longest_pause;
+
+    std::thread _thread;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_DEFRAGMENTER_H
@@ -7,6 +7,12 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * Handle to the memory block allocated by Simple. Holds a reference to the descriptor
+ * inside of the allocator rather than to memory itself, so allocator is free to move block
+ * around during defragmentation. Because of that raw address returned by get() is valid only
+ * until next call to any allocator method
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +23,15 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const { return _slot == nullptr ? nullptr : *_slot; }
+
+private:
+    friend class Simple;
+
+    Pointer(void **slot);
+
+    // Descriptor of the block inside of the allocator, nullptr if pointer is empty
+    void **_slot;
 };
 
 } // namespace Allocator
@@ -0,0 +1,65 @@
+#ifndef AFINA_ALLOCATOR_REBALANCER_H
+#define AFINA_ALLOCATOR_REBALANCER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace Afina {
+namespace Allocator {
+
+// Forward declaration. Do not include real class definition
+// to avoid expensive macros calculations and increase compile speed
+class Slab;
+
+/**
+ * # Slab automove
+ * Background thread running Slab::automove() each interval under the lock shared with allocator
+ * users, so that memory follows changes in the size distribution of stored values
+ */
+class Rebalancer {
+public:
+    Rebalancer(Slab &allocator, std::mutex &lock,
+               std::chrono::milliseconds interval = std::chrono::milliseconds(1000), std::size_t windows = 3);
+    ~Rebalancer();
+
+    /**
+     * Spawns background thread
+     */
+    void Start();
+
+    /**
+     * Stops background thread, blocks until it is done
+     */
+    void Stop();
+
+private:
+    Rebalancer(const Rebalancer &) = delete;
+    Rebalancer &operator=(const Rebalancer &) = delete;
+
+    void OnRun();
+
+    Slab &_allocator;
+
+    // Lock shared with allocator users
+    std::mutex &_lock;
+
+    const std::chrono::milliseconds _interval;
+
+    // Number of consecutive rounds class must starve to get a page
+    const std::size_t _windows;
+
+    // Protects state below
+    std::mutex _mutex;
+    std::condition_variable _stop_condition;
+    bool _running;
+
+    std::thread _thread;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_REBALANCER_H
@@ -1,8 +1,9 @@
 #ifndef AFINA_ALLOCATOR_SIMPLE_H
 #define AFINA_ALLOCATOR_SIMPLE_H
 
-#include <string>
 #include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace Afina {
 namespace Allocator {
@@ -18,6 +19,16 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * Blocks are placed one after another from the beginning of the area, each prefixed by a small
+ * header. Table of descriptors grows from the end of the area towards blocks, every Pointer
+ * references one descriptor, so blocks could be moved without Pointer's owners noticing.
+ *
+ * Free blocks between alive ones are merged with free neighbours right away and kept in segregated
+ * lists by size: exact classes for small sizes and four classes per power of two above, so that
+ * fitting block is found without walking the area.
+ *
+ * Not threadsafe
  */
 // TODO: Implements interface to allow usage as C++ allocators
 class Simple {
@@ -25,37 +36,105 @@ public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes. Throws AllocError of type NoMemory if there is no
+     * continuous free space of required size, defrag() might help in a such case
+     *
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block referenced by p to be at least N bytes, preserving its content. Block
+     * is resized in place if possible and moved otherwise. Empty pointer is allocated from scratch
+     *
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases block referenced by p and resets p. Throws AllocError of type InvalidFree if p
+     * doesn't reference alive block
+     *
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Moves all blocks to the beginning of the area, so that all free space turns into one continuous
+     * region
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Performs bounded part of defrag(): closes the lowest hole by moving blocks that follow it until
+     * at least max_bytes are moved (at least one block is moved on each call). Returns true if there are
+     * still holes to close, so that caller could spread compaction over time
+     *
+     * @param max_bytes size_t
+     */
+    bool defrag_step(size_t max_bytes);
+
+    /**
+     * Returns human readable layout of the memory area
      */
     std::string dump() const;
 
+    /**
+     * Number of bytes requested by alive blocks
+     */
+    size_t used() const { return _used; }
+
+    /**
+     * Number of bytes in free blocks that are placed between alive ones, i.e space that could only
+     * be reused by allocations of fitting size until next defragmentation
+     */
+    size_t fragmented() const { return _holes_size; }
+
 private:
+    struct block;
+
+    // Number of free block classes, see class_of
+    static const size_t kClasses = 256;
+
+    block *first_block() const;
+    block *next_block(block *b) const;
+    block *prev_block(block *b) const;
+    block *find_free(size_t size);
+    block *make_block(size_t size);
+    void split_block(block *b, size_t size);
+    void release_block(block *b);
+    void link_free(block *b);
+    void unlink_free(block *b);
+    void **take_slot();
+    void release_slot(void **slot);
+
     void *_base;
     const size_t _base_len;
+
+    // Border between blocks and free space
+    char *_top;
+
+    // Lowest descriptor in the table, table occupies [_table, _table_end)
+    void **_table;
+    void **_table_end;
+
+    // List of released descriptors
+    void **_free_slots;
+
+    // Number of free blocks below _top and total number of bytes in them (headers included)
+    size_t _holes;
+    size_t _holes_size;
+
+    // Lists of free blocks by class and bitmap of non empty ones
+    block *_free_blocks[kClasses];
+    uint64_t _classes_used[kClasses / 64];
+
+    // Block no higher than the lowest free one, defragmentation looks for a hole starting from it
+    block *_defrag_from;
+
+    // Payload bytes in alive blocks
+    size_t _used;
 };
 
 } // namespace Allocator
@@ -0,0 +1,156 @@
+#ifndef AFINA_ALLOCATOR_SLAB_H
+#define AFINA_ALLOCATOR_SLAB_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Slab allocator
+ * Wraps given memory area, splits it into pages of equal size and hands pages out to size classes. Each
+ * class cuts its pages into chunks of the same size, so allocation is just a pop from the class free list.
+ *
+ * Once area is exhausted memory stays assigned to the classes it was given to. If size distribution changes
+ * later, some classes starve (allocations fail and owner has to evict) while others hold unused chunks.
+ * Automove fixes that: it tracks failures per class and moves whole pages from cold classes to the starving
+ * one, evicting chunks still alive on the moved page through owner's callback.
+ *
+ * Allocator instance doesn't take ownership of wrapped memmory. Not threadsafe
+ *
+ * No storage is built on top of the allocator yet, so its counters (automove ones included) are seen only
+ * by the code embedding it, through stats() and moves(), not by the server's stats command
+ */
+class Slab {
+public:
+    /**
+     * Per class counters
+     */
+    struct ClassStats {
+        size_t chunk_size;
+        size_t pages;
+        size_t used;
+        size_t free;
+
+        // Allocations failed because class has no memory, owner evicts something in response
+        size_t evictions;
+    };
+
+    /**
+     * Callback to evict alive chunk from the page being moved, it must release chunk by calling free()
+     */
+    using Evictor = std::function<void(void *chunk)>;
+
+    /**
+     * @param base memory area to manage
+     * @param size size of the area
+     * @param page_size size of the page, the biggest chunk allocator could return
+     * @param min_chunk size of the smallest class
+     * @param factor growth factor between neighbour classes
+     */
+    Slab(void *base, size_t size, size_t page_size = 64 * 1024, size_t min_chunk = 64, double factor = 1.25);
+
+    /**
+     * Returns chunk of at least N bytes, or nullptr if class serving that size has no free chunks and there
+     * are no free pages left. In the latter case caller should evict something of similar size and retry.
+     * Throws AllocError of type NoMemory if N is bigger than the page
+     */
+    void *alloc(size_t N);
+
+    /**
+     * Returns chunk back to its class. Throws AllocError of type InvalidFree if p doesn't belong to allocator
+     */
+    void free(void *p);
+
+    /**
+     * Index of the class serving allocations of N bytes
+     */
+    size_t class_of(size_t N) const;
+
+    /**
+     * Sets callback used to evict chunks during page moves. Without it only pages with no alive
+     * chunks could be moved
+     */
+    void set_evictor(Evictor evictor) { _evictor = std::move(evictor); }
+
+    /**
+     * Moves one page from class `from` to class `to`. Page with the least number of alive chunks is selected,
+     * all of them are evicted. Returns false if page can't be moved
+     */
+    bool move_page(size_t from, size_t to);
+
+    /**
+     * Single round of automove, should be called periodically. Class which has the most evictions during
+     * `windows` consecutive rounds gets page from the class with no evictions during the last round.
+     * Returns true if page has been moved
+     */
+    bool automove(size_t windows = 3);
+
+    /**
+     * Counters for each class
+     */
+    std::vector<ClassStats> stats() const;
+
+    /**
+     * Total number of pages moved between classes
+     */
+    size_t moves() const { return _moves; }
+
+    /**
+     * Returns human readable state of all classes
+     */
+    std::string dump() const;
+
+private:
+    struct chunk {
+        chunk *next;
+    };
+
+    struct page_class {
+        size_t chunk_size;
+        size_t chunks_per_page;
+        size_t pages;
+        size_t used;
+        size_t evictions;
+
+        // evictions observed on previous automove round
+        size_t last_evictions;
+        chunk *free_list;
+    };
+
+    struct page {
+        // Class page belongs to, or kNoClass for unassigned page
+        size_t owner;
+        size_t used;
+    };
+
+    static const size_t kNoClass = size_t(-1);
+
+    bool grow(size_t cls);
+    void carve(size_t index, size_t cls);
+    char *page_begin(size_t index) const { return _begin + index * _page_size; }
+
+    char *_begin;
+    const size_t _page_size;
+
+    std::vector<page_class> _classes;
+    std::vector<page> _pages;
+
+    // Pages not given to any class
+    std::vector<size_t> _free_pages;
+
+    Evictor _evictor;
+
+    // Automove state
+    size_t _starving;
+    size_t _streak;
+    size_t _moves;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_H
@@ -1,21 +1,30 @@
 #ifndef AFINA_CONCURRENCY_EXECUTOR_H
 #define AFINA_CONCURRENCY_EXECUTOR_H
 
-#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <thread>
-#include <unordered_map>
 
 namespace Afina {
 namespace Concurrency {
 
+class Executor;
+
+/**
+ * Body of pool threads, see Executor
+ */
+void perform(Executor *executor);
+
 /**
  * # Thread pool
+ * Keeps at least low watermark threads alive and starts new ones up to high watermark once queued tasks
+ * outnumber free threads. Thread above low watermark exits after it has been idle for the given timeout.
+ * Tasks that no thread could take right away wait in the bounded queue
  */
 class Executor {
     enum class State {
@@ -30,12 +39,24 @@ class Executor {
         kStopped
     };
 
+public:
+    /**
+     * @param name prefix of threads names
+     * @param size maximum number of tasks waiting for a free thread
+     * @param high maximum number of threads
+     * @param low number of threads kept alive even if there is nothing to do
+     * @param timeout milliseconds thread above low watermark stays idle before it exits
+     */
     Executor(std::string name, std::size_t size, std::size_t high = 6, std::size_t low = 1, std::size_t timeout = 100)
-        : _max_queue_size(size), _high_watermark(high), _low_watermark(low), _idle_time(timeout), _free_threads(low),
-          _active_threads(0) {}
+        : _name(std::move(name)), _max_queue_size(size), _high_watermark(high), _low_watermark(low),
+          _idle_time(timeout), _threads(0), _free_threads(0), state(State::kStopped) {}
     ~Executor() { Stop(true); }
 
+    /**
+     * Starts low watermark threads, after that pool accepts tasks
+     */
     void Start();
+
     /**
      * Signal thread pool to stop, it will stop accepting new jobs and close threads just after each become
      * free. All enqueued jobs will be complete.
@@ -56,19 +77,19 @@ class Executor {
         auto exec = std::bind(std::forward<F>(func), std::forward<Types>(args)...);
 
         std::unique_lock<std::mutex> lock(this->mutex);
-        if (tasks.size() >= _max_queue_size) {
+        if (state != State::kRun) {
             return false;
         }
-        if (state != State::kRun) {
+
+        // Tasks taken by free threads or threads yet to start don't wait, the rest must fit in queue size
+        if (tasks.size() >= _free_threads + (_high_watermark - _threads) + _max_queue_size) {
             return false;
         }
 
-        // Enqueue new task
+        // Enqueue new task, start one more thread if free ones aren't enough to take all tasks
         tasks.push_back(exec);
-        if (_active_threads+_free_threads < _high_watermark && _free_freads == 0) {
-            std::thread t(&perform, this);
-            t.detach();
-            --_active_threads;
+        if (tasks.size() > _free_threads && _threads < _high_watermark) {
+            StartThread();
         }
         empty_condition.notify_one();
         return true;
@@ -76,16 +97,30 @@ class Executor {
 
 private:
     // No copy/move/assign allowed
-    Executor(const Executor &);            // = delete;
-    Executor(Executor &&);                 // = delete;
-    Executor &operator=(const Executor &); // = delete;
-    Executor &operator=(Executor &&);      // = delete;
+    Executor(const Executor &) = delete;
+    Executor(Executor &&) = delete;
+    Executor &operator=(const Executor &) = delete;
+    Executor &operator=(Executor &&) = delete;
+
+    /**
+     * Spawns new free thread, must be called under the mutex
+     */
+    void StartThread();
 
     /**
      * Main function that all pool threads are running. It polls internal task queue and execute tasks
      */
     friend void perform(Executor *executor);
 
+    // Prefix of threads names
+    const std::string _name;
+
+    // Pool settings, see constructor
+    const std::size_t _max_queue_size;
+    const std::size_t _high_watermark;
+    const std::size_t _low_watermark;
+    const std::chrono::milliseconds _idle_time;
+
     /**
      * Mutex to protect state below from concurrent modification
      */
@@ -97,10 +132,12 @@ private:
     std::condition_variable empty_condition;
 
     /**
-     * Vector of actual threads that perorm execution
+     * Number of running threads and those of them waiting for a task. Threads are detached, pool tracks
+     * them by counters only
      */
-    // std::unordered_map<std::thread::id,std::thread> threads;
-    std::size_t _active_threads;
+    std::size_t _threads;
+    std::size_t _free_threads;
+
     /**
      * Task queue
      */
@@ -111,13 +148,10 @@ private:
      */
     State state;
 
+    /**
+     * Signalled once the last thread exits
+     */
     std::condition_variable stop_condition;
-
-    std::size_t _high_watermark;
-    std::size_t _low_watermark;
-    std::size_t _max_queue_size;
-    std::chrono::milliseconds _idle_time;
-    std::size_t _free_threads;
 };
 
 } // namespace Concurrency
@@ -31,18 +31,21 @@ namespace Execute {
  * hold items with such keys (because they were never stored, or stored
  * but deleted to make space for more items, or expired, or explicitly
  * deleted by a client).
+ *
+ * Command refers to the keys given, so they must outlive it
  */
 class Get : public Command {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    Get(const std::vector<std::string> &keys) : _first(keys.data()), _last(keys.data() + keys.size()) {}
+    Get(const std::string *first, const std::string *last) : _first(first), _last(last) {}
     ~Get() {}
 
-    inline const std::vector<std::string> &keys() const { return _keys; }
+    inline std::vector<std::string> keys() const { return std::vector<std::string>(_first, _last); }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
 private:
-    std::vector<std::string> _keys;
+    const std::string *_first, *_last;
 };
 
 } // namespace Execute
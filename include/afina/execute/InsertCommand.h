@@ -11,7 +11,7 @@ namespace Execute {
 
 /**
  * # Basic class for all insert commands
- *
+ * Command refers to the key given, so key must outlive it
  */
 class InsertCommand : public Command {
 public:
@@ -19,11 +19,11 @@ public:
     ~InsertCommand() {}
 
     inline const std::string &key() const { return _key; }
-    inline const uint32_t flags() const { return _flags; }
-    inline const int32_t expire() const { return _expire; }
+    inline uint32_t flags() const { return _flags; }
+    inline int32_t expire() const { return _expire; }
 
 protected:
-    const std::string _key;
+    const std::string &_key;
     const uint32_t _flags;
     const int32_t _expire;
 };
@@ -0,0 +1,44 @@
+#ifndef AFINA_NETWORK_OPTIONS_H
+#define AFINA_NETWORK_OPTIONS_H
+
+#include <cstdint>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Network service settings
+ * Where to listen, how many threads to run and how to tune TCP sockets. Tuning is applied to listening
+ * socket, accepted connections inherit it. Zero keeps the system default for all numeric tuning values
+ */
+struct Options {
+    // TCP port to listen on
+    uint16_t port = 8080;
+
+    // Threads accepting connections and threads serving them, servers that have no such threads ignore them
+    uint32_t acceptors = 2;
+    uint32_t workers = 2;
+
+    // Connections kernel queues until server accepts them, capped by net.core.somaxconn. Queue that is too
+    // short drops SYNs under connection bursts and client retransmits them only after a second or more
+    uint32_t backlog = 1024;
+
+    // Disables Nagle's algorithm, so small responses don't wait for ACK of the previous ones
+    bool nodelay = false;
+
+    // Seconds kernel holds connection that hasn't sent anything yet instead of passing it to accept
+    uint32_t defer_accept = 0;
+
+    // Socket buffer sizes in bytes, kernel doubles them for bookkeeping
+    uint32_t rcvbuf = 0;
+    uint32_t sndbuf = 0;
+
+    // Microseconds blocking receive and epoll busy poll device queue before sleeping, needs CAP_NET_ADMIN
+    // to go above net.core.busy_read
+    uint32_t busy_poll = 0;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_OPTIONS_H
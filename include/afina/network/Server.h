@@ -1,9 +1,14 @@
 #ifndef AFINA_NETWORK_SERVER_H
 #define AFINA_NETWORK_SERVER_H
 
+#include <cstddef>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include <afina/network/Options.h>
+
 namespace Afina {
 class Storage;
 namespace Logging {
@@ -24,9 +29,9 @@ public:
     /**
      * Starts network service. After method returns process should
      * listen on the given interface/port pair to process  incomming
-     * data in workers number of threads
+     * data in workers number of threads, see Options.h
      */
-    virtual void Start(uint16_t port, uint32_t acceptors = 1, uint32_t workers = 1) = 0;
+    virtual void Start(const Options &options) = 0;
 
     /**
      * Signal all worker threads that server is going to shutdown. After method returns
@@ -44,6 +49,35 @@ public:
      */
     virtual void Join() = 0;
 
+    /**
+     * Appends network counters to the given output parameter as name/value pairs
+     *
+     * @param stats output parameter to append counters to
+     */
+    virtual void Stats(std::vector<std::pair<std::string, std::size_t>> &) const {}
+
+    /**
+     * Gives server listening sockets inherited from the process it takes over, see network/common/Handover.h.
+     * Server accepts on them instead of creating own ones. Must be called before Start.
+     *
+     * Returns false if server doesn't support that, sockets stay with the caller then
+     */
+    virtual bool Inherit(const std::vector<int> &) { return false; }
+
+    /**
+     * Listening sockets to be passed to the process taking over. Server keeps accepting on them until Stop.
+     * Safe to call while server runs.
+     *
+     * Returns nothing if server doesn't support that
+     */
+    virtual std::vector<int> Listening() { return {}; }
+
+    /**
+     * Tells server the process taking over has got its listening sockets, so server won't remove anything
+     * they are bound to once it stops. Safe to call while server runs
+     */
+    virtual void Release() {}
+
 protected:
     /**
      * Instance of backing storeage on which current server should execute
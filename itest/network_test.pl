@@ -2,9 +2,10 @@
 use 5.016;
 use warnings;
 use threads;
-use Test::More tests => 85;
+use Test::More tests => 87;
 use IO::Socket::INET;
 use Getopt::Long;
+use POSIX ();
 
 # horrible gut digging to persuade `explain` to print source code
 no warnings 'once';
@@ -217,3 +218,31 @@ afina_test(
 	"Correct result of partially written command",
 	0
 );
+
+SKIP: {
+	skip "FIFO is never closed by the client", 2 if defined $rfifo;
+
+	# small window makes server queue responses while reading is already over, all of them must come
+	# before the close. Window scale is negotiated on connect, so buffer is set before
+	my $socket = IO::Socket::INET::->new(Proto => "tcp");
+	setsockopt($socket, SOL_SOCKET, SO_RCVBUF, 4096);
+	ok($socket->connect(pack_sockaddr_in($port, inet_aton($server))), "Connected to Afina");
+	my $count = 40000;
+	my $writer = fork();
+	if (defined $writer and $writer == 0) {
+		my $request = "set pipe 0 0 100\r\n" . ("x" x 100) . "\r\n" . ("get pipe\r\n" x $count);
+		while (length $request) {
+			my $sent = syswrite($socket, $request) or last;
+			substr($request, 0, $sent) = "";
+		}
+		shutdown($socket, SHUT_WR());
+		POSIX::_exit(0); # leave test reporting to the parent
+	}
+	shutdown($socket, SHUT_WR()) unless defined $writer;
+	my $reply = "";
+	$reply .= $_ while (<$socket>);
+	waitpid($writer, 0) if defined $writer;
+
+	my $ends = () = $reply =~ /END\r\n/g;
+	is($ends, $count, "All responses to pipeline are sent before closing half-closed connection");
+}
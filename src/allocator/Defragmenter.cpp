@@ -0,0 +1,80 @@
+#include <afina/allocator/Defragmenter.h>
+
+#include <algorithm>
+
+#include <afina/allocator/Simple.h>
+
+namespace Afina {
+namespace Allocator {
+
+// See Defragmenter.h
+Defragmenter::Defragmenter(Simple &allocator, std::mutex &lock, std::chrono::microseconds max_pause,
+                           std::chrono::microseconds interval)
+    : _allocator(allocator), _lock(lock), _max_pause(max_pause), _interval(interval), _running(false),
+      _longest_pause(0) {}
+
+// See Defragmenter.h
+Defragmenter::~Defragmenter() { Stop(); }
+
+// See Defragmenter.h
+void Defragmenter::Start() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_running) {
+        _running = true;
+        _thread = std::thread(&Defragmenter::OnRun, this);
+    }
+}
+
+// See Defragmenter.h
+void Defragmenter::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _running = false;
+        _stop_condition.notify_all();
+    }
+
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+// See Defragmenter.h
+bool Defragmenter::Step() {
+    bool more = true;
+    std::chrono::microseconds longest(0);
+    auto start = std::chrono::steady_clock::now();
+    for (auto now = start; more && now - start < _max_pause;) {
+        // Allocator users wait for a single block move at most
+        std::lock_guard<std::mutex> lock(_lock);
+        auto locked = std::chrono::steady_clock::now();
+        more = _allocator.defrag_step(1);
+        now = std::chrono::steady_clock::now();
+        longest = std::max(longest, std::chrono::duration_cast<std::chrono::microseconds>(now - locked));
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (longest > _longest_pause) {
+        _longest_pause = longest;
+    }
+    return more;
+}
+
+// See Defragmenter.h
+std::chrono::microseconds Defragmenter::longest_pause() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _longest_pause;
+}
+
+void Defragmenter::OnRun() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_running) {
+        lock.unlock();
+        Step();
+        lock.lock();
+
+        _stop_condition.wait_for(lock, _interval, [this] { return !_running; });
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,50 @@
+#include <afina/allocator/Rebalancer.h>
+
+#include <afina/allocator/Slab.h>
+
+namespace Afina {
+namespace Allocator {
+
+// See Rebalancer.h
+Rebalancer::Rebalancer(Slab &allocator, std::mutex &lock, std::chrono::milliseconds interval, std::size_t windows)
+    : _allocator(allocator), _lock(lock), _interval(interval), _windows(windows), _running(false) {}
+
+// See Rebalancer.h
+Rebalancer::~Rebalancer() { Stop(); }
+
+// See Rebalancer.h
+void Rebalancer::Start() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_running) {
+        _running = true;
+        _thread = std::thread(&Rebalancer::OnRun, this);
+    }
+}
+
+// See Rebalancer.h
+void Rebalancer::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _running = false;
+        _stop_condition.notify_all();
+    }
+
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void Rebalancer::OnRun() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop_condition.wait_for(lock, _interval, [this] { return !_running; })) {
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            _allocator.automove(_windows);
+        }
+        lock.lock();
+    }
+}
+
+} // namespace Allocator
+} // namespace Afina
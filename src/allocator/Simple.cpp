@@ -1,40 +1,412 @@
 #include <afina/allocator/Simple.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
-/**
- * TODO: semantics
- * @param N size_t
- */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
-
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
-
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
-
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
-
-/**
- * TODO: semantics
- */
-std::string Simple::dump() const { return ""; }
+namespace {
+
+// Every block starts and ends at this boundary
+const size_t kAlign = 2 * sizeof(void *);
+
+// Set in block header if block right before it is free
+const size_t kPrevFree = 1;
+
+inline size_t align_up(size_t v) { return (v + kAlign - 1) & ~(kAlign - 1); }
+
+} // namespace
+
+// Header of each block, payload follows right after it. Payload of free block starts with links
+// of its list and ends with its size, so that the next block could find it
+struct Simple::block {
+    // Payload size in bytes, the lowest bit is kPrevFree
+    size_t info;
+
+    // Descriptor referencing this block, nullptr for free one
+    void **slot;
+
+    size_t size() const { return info & ~kPrevFree; }
+    void set_size(size_t size) { info = size | (info & kPrevFree); }
+
+    bool prev_free() const { return (info & kPrevFree) != 0; }
+    void set_prev_free(bool free) { info = free ? (info | kPrevFree) : (info & ~kPrevFree); }
+
+    block *&prev_link() { return reinterpret_cast<block **>(this + 1)[0]; }
+    block *&next_link() { return reinterpret_cast<block **>(this + 1)[1]; }
+    size_t &footer() {
+        return *reinterpret_cast<size_t *>(reinterpret_cast<char *>(this + 1) + size() - sizeof(size_t));
+    }
+};
+
+namespace {
+
+// Smallest payload: free block must hold its links and footer
+const size_t kMinPayload = align_up(3 * sizeof(void *));
+
+inline size_t payload_size(size_t N) { return std::max(align_up(N == 0 ? 1 : N), kMinPayload); }
+
+// Payloads below 16 units of kAlign have a class per size, larger ones are split into four classes
+// per power of two
+inline size_t class_of(size_t size) {
+    size_t units = size / kAlign;
+    if (units < 16) {
+        return units;
+    }
+    size_t msb = 63 - __builtin_clzll(units);
+    return 16 + (msb - 4) * 4 + ((units >> (msb - 2)) & 3);
+}
+
+// True if size is the smallest one of its class, so that any block of the class fits it
+inline bool class_floor(size_t size) {
+    size_t units = size / kAlign;
+    if (units < 16) {
+        return true;
+    }
+    size_t msb = 63 - __builtin_clzll(units);
+    return (units & ((size_t(1) << (msb - 2)) - 1)) == 0;
+}
+
+// Released descriptors are linked into a list, they are marked by the lowest bit which is
+// never set in a real block address
+inline bool is_free_slot(void *v) { return (reinterpret_cast<uintptr_t>(v) & 1) != 0; }
+inline void *tag_slot(void **next) { return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(next) | 1); }
+inline void **untag_slot(void *v) { return reinterpret_cast<void **>(reinterpret_cast<uintptr_t>(v) & ~uintptr_t(1)); }
+
+} // namespace
+
+Simple::Simple(void *base, size_t size)
+    : _base(base), _base_len(size), _free_slots(nullptr), _holes(0), _holes_size(0), _used(0) {
+    uintptr_t begin = reinterpret_cast<uintptr_t>(base);
+    uintptr_t end = begin + size;
+
+    _top = reinterpret_cast<char *>(align_up(begin));
+    _table_end = reinterpret_cast<void **>(end & ~(uintptr_t(alignof(void *)) - 1));
+    _table = _table_end;
+
+    std::fill(std::begin(_free_blocks), std::end(_free_blocks), nullptr);
+    std::fill(std::begin(_classes_used), std::end(_classes_used), 0);
+    _defrag_from = first_block();
+}
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    size_t size = payload_size(N);
+    void **slot = take_slot();
+    if (slot == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No space for block descriptor");
+    }
+
+    block *b = find_free(size);
+    if (b == nullptr) {
+        b = make_block(size);
+    }
+
+    if (b == nullptr) {
+        release_slot(slot);
+        throw AllocError(AllocErrorType::NoMemory, "No continuous space for " + std::to_string(N) + " bytes");
+    }
+
+    b->slot = slot;
+    *slot = b + 1;
+    _used += b->size();
+    return Pointer(slot);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._slot == nullptr) {
+        p = alloc(N);
+        return;
+    }
+
+    if (p._slot < _table || p._slot >= _table_end || is_free_slot(*p._slot)) {
+        throw AllocError(AllocErrorType::InvalidFree, "Realloc of pointer that doesn't belong to allocator");
+    }
+
+    size_t size = payload_size(N);
+    block *b = static_cast<block *>(*p._slot) - 1;
+    _used -= b->size();
+
+    // Absorb free neighbour, may be it is enough to grow in place. Free blocks are always merged, so
+    // there is at most one
+    block *next = next_block(b);
+    if (reinterpret_cast<char *>(next) < _top && next->slot == nullptr) {
+        unlink_free(next);
+        b->set_size(b->size() + sizeof(block) + next->size());
+        _defrag_from = std::min(_defrag_from, b);
+        next = next_block(b);
+    }
+
+    // Last block could grow up to descriptors table
+    if (b->size() < size && reinterpret_cast<char *>(next) == _top &&
+        reinterpret_cast<char *>(b + 1) + size <= reinterpret_cast<char *>(_table)) {
+        b->set_size(size);
+        _top = reinterpret_cast<char *>(next_block(b));
+        _defrag_from = std::min(_defrag_from, b);
+    }
+
+    if (b->size() >= size) {
+        split_block(b, size);
+        _used += b->size();
+        return;
+    }
+
+    // No way to grow in place, move block somewhere else
+    block *nb = find_free(size);
+    if (nb == nullptr) {
+        nb = make_block(size);
+    }
+
+    if (nb == nullptr) {
+        _used += b->size();
+        throw AllocError(AllocErrorType::NoMemory, "No continuous space for " + std::to_string(N) + " bytes");
+    }
+
+    std::memcpy(nb + 1, b + 1, b->size());
+    nb->slot = p._slot;
+    *p._slot = nb + 1;
+    _used += nb->size();
+
+    // Block b is already excluded from _used
+    release_block(b);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._slot == nullptr || p._slot < _table || p._slot >= _table_end || is_free_slot(*p._slot)) {
+        throw AllocError(AllocErrorType::InvalidFree, "Free of pointer that doesn't belong to allocator");
+    }
+
+    block *b = static_cast<block *>(*p._slot) - 1;
+    _used -= b->size();
+    release_block(b);
+    release_slot(p._slot);
+    p._slot = nullptr;
+}
+
+// See Simple.h
+void Simple::defrag() {
+    while (defrag_step(SIZE_MAX)) {
+    }
+}
+
+// See Simple.h
+bool Simple::defrag_step(size_t max_bytes) {
+    if (_holes == 0) {
+        return false;
+    }
+
+    block *cur = _defrag_from;
+    while (reinterpret_cast<char *>(cur) < _top && cur->slot != nullptr) {
+        cur = next_block(cur);
+    }
+
+    // Slide alive blocks down over the hole, hole "bubbles" up until budget is over
+    char *dst = reinterpret_cast<char *>(cur);
+    size_t moved = 0;
+    while (reinterpret_cast<char *>(cur) < _top) {
+        block *next = next_block(cur);
+        if (cur->slot == nullptr) {
+            unlink_free(cur);
+        } else if (moved > 0 && moved >= max_bytes) {
+            break;
+        } else {
+            size_t total = sizeof(block) + cur->size();
+            std::memmove(dst, cur, total);
+
+            block *nb = reinterpret_cast<block *>(dst);
+            nb->set_prev_free(false);
+            *nb->slot = nb + 1;
+            dst += total;
+            moved += total;
+        }
+        cur = next;
+    }
+
+    _defrag_from = reinterpret_cast<block *>(dst);
+    if (reinterpret_cast<char *>(cur) >= _top) {
+        _top = dst;
+    } else {
+        // Holes are at least as big as the smallest block, so is their sum
+        block *hole = reinterpret_cast<block *>(dst);
+        hole->info = reinterpret_cast<char *>(cur) - dst - sizeof(block);
+        hole->slot = nullptr;
+        link_free(hole);
+    }
+
+    return _holes > 0;
+}
+
+// See Simple.h
+std::string Simple::dump() const {
+    std::stringstream out;
+    out << "used=" << _used << " holes=" << _holes << "/" << _holes_size
+        << " free=" << (reinterpret_cast<char *>(_table) - _top) << " descriptors=" << (_table_end - _table) << "\n";
+
+    for (block *b = first_block(); reinterpret_cast<char *>(b) < _top; b = next_block(b)) {
+        out << (b->slot == nullptr ? "[free " : "[used ") << b->size() << "]";
+    }
+    return out.str();
+}
+
+Simple::block *Simple::first_block() const {
+    return reinterpret_cast<block *>(align_up(reinterpret_cast<uintptr_t>(_base)));
+}
+
+Simple::block *Simple::next_block(block *b) const {
+    return reinterpret_cast<block *>(reinterpret_cast<char *>(b + 1) + b->size());
+}
+
+Simple::block *Simple::prev_block(block *b) const {
+    size_t size = *(reinterpret_cast<size_t *>(b) - 1);
+    return reinterpret_cast<block *>(reinterpret_cast<char *>(b) - size) - 1;
+}
+
+Simple::block *Simple::find_free(size_t size) {
+    if (_holes == 0) {
+        return nullptr;
+    }
+
+    // Any block of the larger classes fits, take the first one of the smallest non empty class
+    size_t own = class_of(size);
+    size_t c = class_floor(size) ? own : own + 1;
+    block *b = nullptr;
+    for (size_t word = c / 64; word < kClasses / 64 && b == nullptr; word++) {
+        uint64_t used = _classes_used[word];
+        if (word == c / 64) {
+            used &= ~uint64_t(0) << (c % 64);
+        }
+        if (used != 0) {
+            b = _free_blocks[word * 64 + __builtin_ctzll(used)];
+        }
+    }
+
+    // Otherwise the only chance is a block of the same class
+    if (b == nullptr && c != own) {
+        for (b = _free_blocks[own]; b != nullptr && b->size() < size; b = b->next_link()) {
+        }
+    }
+
+    if (b == nullptr) {
+        return nullptr;
+    }
+
+    unlink_free(b);
+    split_block(b, size);
+    return b;
+}
+
+Simple::block *Simple::make_block(size_t size) {
+    if (_top + sizeof(block) + size > reinterpret_cast<char *>(_table)) {
+        return nullptr;
+    }
+
+    // Block below the top is never free
+    block *b = reinterpret_cast<block *>(_top);
+    b->info = size;
+    _top += sizeof(block) + size;
+    return b;
+}
+
+void Simple::split_block(block *b, size_t size) {
+    size_t rest_size = b->size() - size;
+    if (rest_size < sizeof(block) + kMinPayload) {
+        return;
+    }
+
+    b->set_size(size);
+    block *rest = next_block(b);
+    rest->info = rest_size - sizeof(block);
+    release_block(rest);
+}
+
+void Simple::release_block(block *b) {
+    b->slot = nullptr;
+
+    block *next = next_block(b);
+    if (reinterpret_cast<char *>(next) < _top && next->slot == nullptr) {
+        unlink_free(next);
+        b->set_size(b->size() + sizeof(block) + next->size());
+    }
+
+    if (b->prev_free()) {
+        block *prev = prev_block(b);
+        unlink_free(prev);
+        prev->set_size(prev->size() + sizeof(block) + b->size());
+        b = prev;
+    }
+
+    // Free space at the end of blocks isn't a hole
+    if (reinterpret_cast<char *>(next_block(b)) == _top) {
+        _top = reinterpret_cast<char *>(b);
+        _defrag_from = std::min(_defrag_from, b);
+    } else {
+        link_free(b);
+    }
+}
+
+void Simple::link_free(block *b) {
+    size_t c = class_of(b->size());
+    b->prev_link() = nullptr;
+    b->next_link() = _free_blocks[c];
+    if (_free_blocks[c] != nullptr) {
+        _free_blocks[c]->prev_link() = b;
+    }
+    _free_blocks[c] = b;
+    _classes_used[c / 64] |= uint64_t(1) << (c % 64);
+
+    b->footer() = b->size();
+    next_block(b)->set_prev_free(true);
+    _defrag_from = std::min(_defrag_from, b);
+
+    _holes++;
+    _holes_size += sizeof(block) + b->size();
+}
+
+void Simple::unlink_free(block *b) {
+    size_t c = class_of(b->size());
+    if (b->prev_link() != nullptr) {
+        b->prev_link()->next_link() = b->next_link();
+    } else {
+        _free_blocks[c] = b->next_link();
+        if (_free_blocks[c] == nullptr) {
+            _classes_used[c / 64] &= ~(uint64_t(1) << (c % 64));
+        }
+    }
+    if (b->next_link() != nullptr) {
+        b->next_link()->prev_link() = b->prev_link();
+    }
+
+    next_block(b)->set_prev_free(false);
+
+    _holes--;
+    _holes_size -= sizeof(block) + b->size();
+}
+
+void **Simple::take_slot() {
+    if (_free_slots != nullptr) {
+        void **slot = _free_slots;
+        _free_slots = untag_slot(*slot);
+        return slot;
+    }
+
+    if (reinterpret_cast<char *>(_table - 1) < _top) {
+        return nullptr;
+    }
+    return --_table;
+}
+
+void Simple::release_slot(void **slot) {
+    *slot = tag_slot(_free_slots);
+    _free_slots = slot;
+}
 
 } // namespace Allocator
 } // namespace Afina
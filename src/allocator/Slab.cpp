@@ -0,0 +1,270 @@
+#include <afina/allocator/Slab.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+// Chunks and pages start at this boundary
+const size_t kAlign = 2 * sizeof(void *);
+
+inline size_t align_up(size_t v) { return (v + kAlign - 1) & ~(kAlign - 1); }
+
+} // namespace
+
+// See Slab.h
+Slab::Slab(void *base, size_t size, size_t page_size, size_t min_chunk, double factor)
+    : _page_size(align_up(page_size)), _starving(kNoClass), _streak(0), _moves(0) {
+    uintptr_t begin = align_up(reinterpret_cast<uintptr_t>(base));
+    uintptr_t end = reinterpret_cast<uintptr_t>(base) + size;
+    _begin = reinterpret_cast<char *>(begin);
+
+    size_t npages = end > begin ? (end - begin) / _page_size : 0;
+    _pages.resize(npages, page{kNoClass, 0});
+    _free_pages.reserve(npages);
+    for (size_t i = npages; i > 0; i--) {
+        _free_pages.push_back(i - 1);
+    }
+
+    // Classes grow geometrically, the last one takes whole page
+    size_t chunk_size = align_up(std::max(min_chunk, sizeof(chunk)));
+    while (chunk_size < _page_size / 2) {
+        _classes.push_back(page_class{chunk_size, _page_size / chunk_size, 0, 0, 0, 0, nullptr});
+
+        size_t next = align_up(size_t(chunk_size * factor));
+        chunk_size = next > chunk_size ? next : chunk_size + kAlign;
+    }
+    _classes.push_back(page_class{_page_size, 1, 0, 0, 0, 0, nullptr});
+}
+
+// See Slab.h
+void *Slab::alloc(size_t N) {
+    if (N > _page_size) {
+        throw AllocError(AllocErrorType::NoMemory, "Slab can't allocate " + std::to_string(N) + " bytes");
+    }
+
+    size_t cls = class_of(N);
+    page_class &c = _classes[cls];
+    if (c.free_list == nullptr && !grow(cls)) {
+        c.evictions++;
+        return nullptr;
+    }
+
+    chunk *result = c.free_list;
+    c.free_list = result->next;
+    c.used++;
+    _pages[(reinterpret_cast<char *>(result) - _begin) / _page_size].used++;
+    return result;
+}
+
+// See Slab.h
+void Slab::free(void *p) {
+    char *ptr = static_cast<char *>(p);
+    if (ptr < _begin || ptr >= page_begin(_pages.size())) {
+        throw AllocError(AllocErrorType::InvalidFree, "Free of pointer that doesn't belong to allocator");
+    }
+
+    size_t index = (ptr - _begin) / _page_size;
+    page &pg = _pages[index];
+    if (pg.owner == kNoClass || pg.used == 0) {
+        throw AllocError(AllocErrorType::InvalidFree, "Free of pointer that doesn't belong to allocator");
+    }
+
+    page_class &c = _classes[pg.owner];
+    size_t offset = ptr - page_begin(index);
+    if (offset % c.chunk_size != 0 || offset / c.chunk_size >= c.chunks_per_page) {
+        throw AllocError(AllocErrorType::InvalidFree, "Free of pointer in the middle of chunk");
+    }
+
+    chunk *ch = reinterpret_cast<chunk *>(ptr);
+    ch->next = c.free_list;
+    c.free_list = ch;
+    c.used--;
+    pg.used--;
+}
+
+// See Slab.h
+size_t Slab::class_of(size_t N) const {
+    size_t lo = 0, hi = _classes.size() - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (_classes[mid].chunk_size < N) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// See Slab.h
+bool Slab::move_page(size_t from, size_t to) {
+    if (from == to || from >= _classes.size() || to >= _classes.size() || _classes[from].pages == 0) {
+        return false;
+    }
+
+    // Victim is the page with the least alive chunks
+    size_t victim = kNoClass;
+    for (size_t i = 0; i < _pages.size(); i++) {
+        if (_pages[i].owner == from && (victim == kNoClass || _pages[i].used < _pages[victim].used)) {
+            victim = i;
+        }
+    }
+
+    page_class &c = _classes[from];
+    char *begin = page_begin(victim);
+    char *end = begin + c.chunk_size * c.chunks_per_page;
+    if (_pages[victim].used > 0) {
+        if (!_evictor) {
+            return false;
+        }
+
+        std::vector<bool> is_free(c.chunks_per_page, false);
+        for (chunk *ch = c.free_list; ch != nullptr; ch = ch->next) {
+            char *p = reinterpret_cast<char *>(ch);
+            if (p >= begin && p < end) {
+                is_free[(p - begin) / c.chunk_size] = true;
+            }
+        }
+
+        for (size_t i = 0; i < c.chunks_per_page; i++) {
+            if (!is_free[i]) {
+                _evictor(begin + i * c.chunk_size);
+            }
+        }
+
+        if (_pages[victim].used > 0) {
+            return false;
+        }
+    }
+
+    // Unlink page chunks from class free list
+    chunk **link = &c.free_list;
+    while (*link != nullptr) {
+        char *p = reinterpret_cast<char *>(*link);
+        if (p >= begin && p < end) {
+            *link = (*link)->next;
+        } else {
+            link = &(*link)->next;
+        }
+    }
+
+    c.pages--;
+    carve(victim, to);
+    _moves++;
+    return true;
+}
+
+// See Slab.h
+bool Slab::automove(size_t windows) {
+    // Evictions since previous round
+    std::vector<size_t> delta(_classes.size());
+    size_t starving = kNoClass;
+    for (size_t i = 0; i < _classes.size(); i++) {
+        delta[i] = _classes[i].evictions - _classes[i].last_evictions;
+        _classes[i].last_evictions = _classes[i].evictions;
+        if (delta[i] > 0 && (starving == kNoClass || delta[i] > delta[starving])) {
+            starving = i;
+        }
+    }
+
+    if (starving == kNoClass) {
+        _starving = kNoClass;
+        _streak = 0;
+        return false;
+    }
+
+    if (starving == _starving) {
+        _streak++;
+    } else {
+        _starving = starving;
+        _streak = 1;
+    }
+
+    if (_streak < windows) {
+        return false;
+    }
+
+    // Donor is a class with no evictions and the most unused memory
+    size_t donor = kNoClass;
+    size_t donor_free = 0;
+    for (size_t i = 0; i < _classes.size(); i++) {
+        const page_class &c = _classes[i];
+        if (i == starving || delta[i] > 0 || c.pages == 0) {
+            continue;
+        }
+
+        size_t free_bytes = (c.pages * c.chunks_per_page - c.used) * c.chunk_size;
+        if (donor == kNoClass || free_bytes > donor_free) {
+            donor = i;
+            donor_free = free_bytes;
+        }
+    }
+
+    if (donor == kNoClass || !move_page(donor, starving)) {
+        return false;
+    }
+
+    _streak = 0;
+    return true;
+}
+
+// See Slab.h
+std::vector<Slab::ClassStats> Slab::stats() const {
+    std::vector<ClassStats> result;
+    result.reserve(_classes.size());
+    for (const page_class &c : _classes) {
+        result.push_back(ClassStats{c.chunk_size, c.pages, c.used, c.pages * c.chunks_per_page - c.used, c.evictions});
+    }
+    return result;
+}
+
+// See Slab.h
+std::string Slab::dump() const {
+    std::stringstream out;
+    out << "pages=" << _pages.size() << " free_pages=" << _free_pages.size() << " moves=" << _moves << "\n";
+    for (size_t i = 0; i < _classes.size(); i++) {
+        const page_class &c = _classes[i];
+        if (c.pages == 0 && c.evictions == 0) {
+            continue;
+        }
+        out << "class " << i << ": chunk=" << c.chunk_size << " pages=" << c.pages << " used=" << c.used
+            << " evictions=" << c.evictions << "\n";
+    }
+    return out.str();
+}
+
+bool Slab::grow(size_t cls) {
+    if (_free_pages.empty()) {
+        return false;
+    }
+
+    size_t index = _free_pages.back();
+    _free_pages.pop_back();
+    carve(index, cls);
+    return true;
+}
+
+void Slab::carve(size_t index, size_t cls) {
+    page_class &c = _classes[cls];
+    _pages[index].owner = cls;
+    _pages[index].used = 0;
+
+    // Push in reverse order so that chunks are handed out in address order
+    char *begin = page_begin(index);
+    for (size_t i = c.chunks_per_page; i > 0; i--) {
+        chunk *ch = reinterpret_cast<chunk *>(begin + (i - 1) * c.chunk_size);
+        ch->next = c.free_list;
+        c.free_list = ch;
+    }
+    c.pages++;
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -1,71 +1,89 @@
 #include <afina/concurrency/Executor.h>
 
+#include <pthread.h>
+
 namespace Afina {
 namespace Concurrency {
 
+// See Executor.h
+void Executor::Start() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (state != State::kStopped) {
+        return;
+    }
+
+    state = State::kRun;
+    while (_threads < _low_watermark) {
+        StartThread();
+    }
+}
+
+// See Executor.h
 void Executor::Stop(bool await) {
     std::unique_lock<std::mutex> lock(mutex);
-    if(state==State::kRun){
-        state=State::kStopping;
-        if(await){
-            stop_condition.wait(lock,[&](){ return _active_threads+_free_threads==0;});
-        }
-    }else{
-        state=State::kStopped;
+    if (state == State::kRun) {
+        state = _threads == 0 ? State::kStopped : State::kStopping;
+
+        // Wake up idle threads so they notice the stop
+        empty_condition.notify_all();
+    }
+
+    if (await) {
+        stop_condition.wait(lock, [this]() { return state == State::kStopped; });
     }
 }
+
+// See Executor.h
+void Executor::StartThread() {
+    std::thread t(&perform, this);
+
+    // Kernel limits name to 15 chars
+    std::string name = _name.substr(0, 15);
+    pthread_setname_np(t.native_handle(), name.c_str());
+    t.detach();
+
+    _threads++;
+    _free_threads++;
+}
+
 void perform(Executor *executor) {
-    std::function<void()> task;
-    while (executor->state == Executor::State::kRun && !executor->tasks.empty()) {
-        {
-            std::unique_lock<std::mutex> lock(executor->mutex);
-            auto timeout = std::chrono::system_clock::now() + executor->_idle_time;
-            while ((executor->state == Executor::State::kRun) && executor->tasks.empty()) {
-                if ((executor->empty_condition.wait_until(lock, timeout) == std::cv_status::timeout) &&
-                    (executor->_active_threads+executor->_free_threads > executor->_low_watermark)) {
-                    break;
-                } else {
-                    executor->empty_condition.wait(lock);
-                }
+    std::unique_lock<std::mutex> lock(executor->mutex);
+    for (;;) {
+        // Wait for a task, thread above low watermark leaves if there is nothing to do for too long
+        bool expired = false;
+        while (executor->tasks.empty() && executor->state == Executor::State::kRun && !expired) {
+            if (executor->empty_condition.wait_for(lock, executor->_idle_time) == std::cv_status::timeout) {
+                expired = executor->_threads > executor->_low_watermark;
             }
-            if (executor->tasks.empty()) {
-                continue;
-            }
-            --executor->_free_threads;
-            ++executor->_active_threads;
-            task = executor->tasks.front();
-            executor->tasks.pop_front();
         }
-        try{
-            task();
-        }catch(...){
-            std::terminate();
-        }
-        {
-             std::unique_lock<std::mutex> lock(executor->mutex);
-            ++executor->_free_threads;
-            --executor->_active_threads;
+
+        // Stop or idle timeout, queued tasks are completed in any case
+        if (executor->tasks.empty()) {
+            break;
         }
-    }
-    {
-        std::unique_lock<std::mutex> lock(executor->mutex);
-        --executor->_free_threads;
-        if (executor->state == Executor::State::kStopping && executor->tasks.size()==0) {
-            executor->state = Executor::State::kStopped;
-            executor->stop_condition.notify_all();
+
+        std::function<void()> task = std::move(executor->tasks.front());
+        executor->tasks.pop_front();
+        executor->_free_threads--;
+        lock.unlock();
+
+        try {
+            task();
+        } catch (...) {
+            // Task is expected to report its errors by itself, pool thread must survive anyway
         }
+
+        lock.lock();
+        executor->_free_threads++;
     }
-}
 
-void Executor::Start()
-{
-    std::unique_lock<std::mutex> lock(mutex);
-    state=State::kRun;
-    for(std::size_t i=0;i<_low_watermark;++i){
-        std::thread t(&(perform), this);
-        t.detach();
-        ++_free_threads;
+    executor->_free_threads--;
+    executor->_threads--;
+    if (executor->_threads == 0 && executor->state == Executor::State::kStopping) {
+        executor->state = Executor::State::kStopped;
+        executor->stop_condition.notify_all();
     }
 }
+
 } // namespace Concurrency
 } // namespace Afina
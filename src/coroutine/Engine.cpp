@@ -19,7 +19,8 @@ void Engine::Store(context &ctx) {
     auto size=ctx.Hight-ctx.Low;
     auto &buf=std::get<char*>(ctx.Stack);
     auto &new_size=std::get<uint32_t>(ctx.Stack);
-    if(std::get<uint32_t>(ctx.Stack)<size)
+    // Restore copies back as many bytes as stored here, so buffer has to match the size exactly
+    if(std::get<uint32_t>(ctx.Stack)!=size)
     {
         delete[] std::get<char*>(ctx.Stack);
         new_size = size;
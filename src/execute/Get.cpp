@@ -2,8 +2,7 @@
 #include <afina/execute/Get.h>
 
 #include <iostream>
-#include <iterator>
-#include <sstream>
+#include <string>
 
 namespace Afina {
 namespace Execute {
@@ -21,23 +20,23 @@ to indicate the end of response.
 
 */
 
-void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::stringstream keyStream;
-    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
-    std::cout << "Get(" << keyStream.str() << ")" << std::endl;
-
-    std::stringstream outStream;
+void Get::Execute(Storage &storage, const std::string &, std::string &out) {
+    std::cout << "Get(";
+    for (auto key = _first; key != _last; ++key) {
+        std::cout << *key << " ";
+    }
+    std::cout << ")" << std::endl;
 
+    // Response is built right in the output, so its capacity is reused by the caller
+    out.clear();
     std::string value;
-    for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+    for (auto key = _first; key != _last; ++key) {
+        if (!storage.Get(*key, value))
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
+        out.append("VALUE ").append(*key).append(" 0 ").append(std::to_string(value.size())).append("\r\n");
+        out.append(value).append("\r\n");
     }
-    outStream << "END"; // networking layer should add the last \r\n
-
-    out = outStream.str();
+    out.append("END"); // networking layer should add the last \r\n
 }
 
 } // namespace Execute
@@ -4,11 +4,34 @@
 #include <iostream>
 #include <iterator>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+/* memcached protocol:
+
+Server responds with a number of lines
+
+STAT <name> <value>\r\n
+
+terminated by the string "END\r\n"
+
+*/
+
+void Stats::Execute(Storage &storage, const std::string &, std::string &out) {
+    std::vector<std::pair<std::string, std::size_t>> stats;
+    storage.Stats(stats);
+
+    std::stringstream outStream;
+    for (auto &stat : stats) {
+        outStream << "STAT " << stat.first << " " << stat.second << "\r\n";
+    }
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
 
 } // namespace Execute
 } // namespace Afina
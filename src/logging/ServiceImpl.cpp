@@ -193,7 +193,7 @@ std::shared_ptr<spdlog::logger> ServiceImpl::select(const std::string &name) noe
         }
 
         std::size_t idx = tmp_name.find_last_of('.');
-        if (idx == -1) {
+        if (idx == std::string::npos) {
             idx = 0;
         }
 
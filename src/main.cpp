@@ -1,11 +1,14 @@
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <memory>
 
 #include <atomic>
+#include <functional>
 #include <semaphore.h>
 #include <signal.h>
 #include <thread>
+#include <unistd.h>
 
 #include <cxxopts.hpp>
 
@@ -15,10 +18,14 @@
 #include <afina/network/Server.h>
 
 #include "logging/ServiceImpl.h"
+#include "network/common/Handover.h"
+#include "network/common/StatsStorage.h"
 #include "network/mt_blocking/ServerImpl.h"
 #include "network/mt_nonblocking/ServerImpl.h"
 #include "network/st_blocking/ServerImpl.h"
+#include "network/st_coroutine/ServerImpl.h"
 #include "network/st_nonblocking/ServerImpl.h"
+#include "network/uring/ServerImpl.h"
 
 #include "storage/SimpleLRU.h"
 #include "storage/ThreadSafeSimpleLRU.h"
@@ -50,10 +57,24 @@ public:
             storage_type = options["storage"].as<std::string>();
         }
 
+        // Budget covers per item overhead as well, see SimpleLRU.h
+        std::size_t storage_size = 64 * 1024 * 1024;
+        if (options.count("storage-size") > 0) {
+            storage_size = options["storage-size"].as<uint64_t>();
+        }
+        if (storage_size == 0) {
+            throw std::runtime_error("Storage needs non empty memory budget");
+        }
+
+        std::size_t max_rss = 0;
+        if (options.count("max-rss") > 0) {
+            max_rss = options["max-rss"].as<uint64_t>();
+        }
+
         if (storage_type == "st_lru") {
-            storage = std::make_shared<Afina::Backend::SimpleLRU>();
+            storage = std::make_shared<Afina::Backend::SimpleLRU>(storage_size, max_rss);
         } else if (storage_type == "mt_lru") {
-            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>();
+            storage = std::make_shared<Afina::Backend::ThreadSafeSimplLRU>(storage_size, max_rss);
         } else {
             throw std::runtime_error("Unknown storage type");
         }
@@ -64,21 +85,139 @@ public:
             network_type = options["network"].as<std::string>();
         }
 
+        // Where to listen and how to tune sockets, see afina/network/Options.h
+        if (options.count("port") > 0) {
+            network.port = options["port"].as<uint16_t>();
+        }
+        if (options.count("acceptors") > 0) {
+            network.acceptors = options["acceptors"].as<uint32_t>();
+        }
+        if (options.count("workers") > 0) {
+            network.workers = options["workers"].as<uint32_t>();
+        }
+        if (options.count("backlog") > 0) {
+            network.backlog = options["backlog"].as<uint32_t>();
+        }
+        network.nodelay = options.count("tcp-nodelay") > 0;
+        if (options.count("defer-accept") > 0) {
+            network.defer_accept = options["defer-accept"].as<uint32_t>();
+        }
+        if (options.count("rcvbuf") > 0) {
+            network.rcvbuf = options["rcvbuf"].as<uint32_t>();
+        }
+        if (options.count("sndbuf") > 0) {
+            network.sndbuf = options["sndbuf"].as<uint32_t>();
+        }
+        if (options.count("busy-poll") > 0) {
+            network.busy_poll = options["busy-poll"].as<uint32_t>();
+        }
+        if (network.workers == 0 || network.backlog == 0) {
+            throw std::runtime_error("Network needs at least one worker and non empty backlog");
+        }
+
+        // Connection timeouts in milliseconds, 0 disables
+        uint32_t idle_timeout = 0, read_timeout = 0;
+        if (options.count("idle-timeout") > 0) {
+            idle_timeout = options["idle-timeout"].as<uint32_t>();
+        }
+        if (options.count("read-timeout") > 0) {
+            read_timeout = options["read-timeout"].as<uint32_t>();
+        }
+
+        // Milliseconds connections have to send queued responses on stop
+        uint32_t drain_timeout = 5000;
+        if (options.count("drain-timeout") > 0) {
+            drain_timeout = options["drain-timeout"].as<uint32_t>();
+        }
+
+        // Work single connection could do before others get their turn
+        Afina::Network::Budget budget;
+        if (options.count("budget-commands") > 0) {
+            budget.commands = options["budget-commands"].as<uint32_t>();
+        }
+        if (options.count("budget-bytes") > 0) {
+            budget.bytes = options["budget-bytes"].as<uint32_t>();
+        }
+
+        // Local endpoints next to TCP port
+        Afina::Network::Listeners listeners;
+        if (options.count("unix-socket") > 0) {
+            listeners.unix_socket = options["unix-socket"].as<std::string>();
+        }
+        if (options.count("rfifo") > 0) {
+            listeners.rfifo = options["rfifo"].as<std::string>();
+        }
+        if (options.count("wfifo") > 0) {
+            listeners.wfifo = options["wfifo"].as<std::string>();
+        }
+        if (options.count("udp-port") > 0) {
+            listeners.udp_port = options["udp-port"].as<uint16_t>();
+        }
+        if (listeners.rfifo.empty() && !listeners.wfifo.empty()) {
+            throw std::runtime_error("FIFO to write responses to requires FIFO to read commands from");
+        }
+
+        // Restart without refusing connections, see network/common/Handover.h
+        if (options.count("handover") > 0) {
+            handover_path = options["handover"].as<std::string>();
+        }
+        if (options.count("takeover") > 0) {
+            takeover_path = options["takeover"].as<std::string>();
+        }
+        if ((!handover_path.empty() || !takeover_path.empty()) && network_type != "mt_nonblock") {
+            throw std::runtime_error("Only mt_nonblock network could be taken over");
+        }
+
+        // Network counters are reported by "stats" command along with storage ones
+        auto network_storage = std::make_shared<Afina::Network::StatsStorage>(storage);
         if (network_type == "st_block") {
-            server = std::make_shared<Afina::Network::STblocking::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STblocking::ServerImpl>(network_storage, logService);
         } else if (network_type == "mt_block") {
-            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(storage, logService);
+            if (options.count("idle-timeout") == 0) {
+                // Connection holds a thread, so don't let it wait forever
+                idle_timeout = 5000;
+            }
+            uint32_t min_threads = 4, max_threads = 64, accept_queue = 64;
+            if (options.count("min-threads") > 0) {
+                min_threads = options["min-threads"].as<uint32_t>();
+            }
+            if (options.count("max-threads") > 0) {
+                max_threads = options["max-threads"].as<uint32_t>();
+            }
+            if (options.count("accept-queue") > 0) {
+                accept_queue = options["accept-queue"].as<uint32_t>();
+            }
+            if (max_threads == 0 || min_threads > max_threads) {
+                throw std::runtime_error("Thread limits must satisfy 0 < min-threads <= max-threads");
+            }
+            server = std::make_shared<Afina::Network::MTblocking::ServerImpl>(
+                network_storage, logService, idle_timeout, read_timeout, min_threads, max_threads, accept_queue);
         } else if (network_type == "st_nonblock") {
-            server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(storage, logService);
+            server = std::make_shared<Afina::Network::STnonblock::ServerImpl>(network_storage, logService, budget,
+                                                                              drain_timeout);
+        } else if (network_type == "st_coroutine") {
+            server = std::make_shared<Afina::Network::STcoroutine::ServerImpl>(network_storage, logService);
         } else if (network_type == "mt_nonblock") {
-            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(storage, logService);
+            bool reuseport = options.count("reuseport") > 0;
+            bool pin_cpu = options.count("pin-cpu") > 0;
+            uint32_t spin = 0;
+            if (options.count("spin") > 0) {
+                spin = options["spin"].as<uint32_t>();
+            }
+            server = std::make_shared<Afina::Network::MTnonblock::ServerImpl>(
+                network_storage, logService, reuseport, pin_cpu, idle_timeout, read_timeout, drain_timeout, budget,
+                listeners, spin);
+        } else if (network_type == "uring") {
+            server = std::make_shared<Afina::Network::Uring::ServerImpl>(network_storage, logService);
         } else {
             throw std::runtime_error("Unknown network type");
         }
+        network_storage->Attach(server.get());
     }
 
-    // Start services in correct order
-    void Start() {
+    // Start services in correct order, taken_over is called once some other process has taken the
+    // service over
+    void Start(std::function<void()> taken_over) {
         logService->Start();
         auto log = logService->select("root");
         log->warn("Start afina server {}", Afina::get_version());
@@ -86,17 +225,76 @@ public:
         log->warn("Start storage");
         storage->Start();
 
-        // TODO: configure network service
-        const uint16_t port = 8080;
-        log->warn("Start network on {}", port);
-        server->Start(port, 2, 2);
+        log->warn("Start network on {}", network.port);
+        if (takeover_path.empty()) {
+            server->Start(network);
+        } else {
+            // Previous process keeps serving until this one confirms it has started
+            Network::Handover takeover(takeover_path, logService->select("network"));
+            std::vector<int> sockets = takeover.Take();
+            if (!server->Inherit(sockets)) {
+                for (int socket : sockets) {
+                    close(socket);
+                }
+                throw std::runtime_error("Network doesn't support takeover");
+            }
+            server->Start(network);
+            takeover.Confirm();
+        }
+
+        if (!handover_path.empty()) {
+            handover.reset(new Network::Handover(handover_path, logService->select("network")));
+            handover->Serve([this]() { return server->Listening(); },
+                            [this, taken_over]() {
+                                server->Release();
+                                taken_over();
+                            });
+        }
+    }
+
+    // Starts new process of the same program to take the service over
+    void Restart(char **argv) {
+        auto log = logService->select("root");
+        if (handover_path.empty()) {
+            log->error("Restart requires --handover");
+            return;
+        }
+
+        // Process started by previous restart has its own takeover option, the one pointing to us goes last
+        std::vector<char *> args;
+        for (char **arg = argv; *arg != nullptr; arg++) {
+            args.push_back(*arg);
+        }
+        std::string takeover = "--takeover";
+        args.push_back(&takeover[0]);
+        args.push_back(&handover_path[0]);
+        args.push_back(nullptr);
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            execvp(args[0], &args[0]);
+            _exit(127);
+        } else if (pid == -1) {
+            log->error("Failed to start new process: {}", strerror(errno));
+        } else {
+            log->warn("Started process {} to take over", pid);
+        }
     }
 
     // Stop services in correct order
     void Stop() {
         auto log = logService->select("root");
         log->warn("Stop application");
+        if (handover) {
+            handover->Stop();
+        }
         server->Stop();
+
+        std::vector<std::pair<std::string, std::size_t>> stats;
+        server->Stats(stats);
+        for (auto &counter : stats) {
+            log->info("Network {}: {}", counter.first, counter.second);
+        }
         server->Join();
 
         storage->Stop();
@@ -109,18 +307,31 @@ private:
 
     std::shared_ptr<Afina::Storage> storage;
     std::shared_ptr<Afina::Network::Server> server;
+    Afina::Network::Options network;
+
+    // Control socket to serve takeover requests at and the one to take the service over from
+    std::string handover_path;
+    std::string takeover_path;
+    std::unique_ptr<Afina::Network::Handover> handover;
 };
 
 // Signal set that to notify application about time to stop
 sem_t stop_semaphore;
 volatile sig_atomic_t stop_reason = 0;
+volatile sig_atomic_t restart_requested = 0;
 
 // Catch user desire to stop the server
-void on_term(int signum, siginfo_t *siginfo, void *data) {
+void on_term(int signum, siginfo_t *, void *) {
     stop_reason = signum;
     sem_post(&stop_semaphore);
 }
 
+// Catch user desire to restart the server
+void on_restart(int, siginfo_t *, void *) {
+    restart_requested = 1;
+    sem_post(&stop_semaphore);
+}
+
 int main(int argc, char **argv) {
     // Command line arguments parsing
     cxxopts::Options options("afina", "Simple memory caching server");
@@ -128,7 +339,60 @@ int main(int argc, char **argv) {
         // TODO: use custom cxxopts::value to print options possible values in help message
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
+        options.add_options()("storage-size", "Memory budget of storage items in bytes, 64MB by default",
+                              cxxopts::value<uint64_t>());
+        options.add_options()("max-rss", "Process RSS in bytes at which storage evicts regardless of budget",
+                              cxxopts::value<uint64_t>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("p,port", "TCP port to listen on, 8080 by default", cxxopts::value<uint16_t>());
+        options.add_options()("acceptors", "Threads accepting connections, 2 by default", cxxopts::value<uint32_t>());
+        options.add_options()("workers", "Threads serving connections, 2 by default", cxxopts::value<uint32_t>());
+        options.add_options()("backlog", "Connections kernel queues until they are accepted, 1024 by default",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("tcp-nodelay", "Disable Nagle's algorithm on connections");
+        options.add_options()("defer-accept", "Seconds kernel holds connection until it sends something",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("rcvbuf", "Socket receive buffer size in bytes", cxxopts::value<uint32_t>());
+        options.add_options()("sndbuf", "Socket send buffer size in bytes", cxxopts::value<uint32_t>());
+        options.add_options()("busy-poll", "Microseconds to busy poll device queue before sleeping (SO_BUSY_POLL)",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("reuseport", "mt_nonblock: each worker accepts on own SO_REUSEPORT socket");
+        options.add_options()("pin-cpu", "mt_nonblock: pin workers to CPUs");
+        options.add_options()("spin", "mt_nonblock: microseconds workers poll for events before sleeping",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("idle-timeout", "mt_block, mt_nonblock: close connection idle for that many ms",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("read-timeout", "mt_block, mt_nonblock: close connection not sent request in that many ms",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("drain-timeout",
+                              "st_nonblock, mt_nonblock: ms connections have to send queued responses on stop",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("min-threads", "mt_block: threads kept ready for new connections",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("max-threads", "mt_block: maximum number of connections served at once",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("accept-queue", "mt_block: connections waiting for a free thread before reject",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("budget-commands",
+                              "st_nonblock, mt_nonblock: commands connection runs per wakeup, 0 for no limit",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("budget-bytes",
+                              "st_nonblock, mt_nonblock: bytes connection reads per wakeup, 0 for no limit",
+                              cxxopts::value<uint32_t>());
+        options.add_options()("unix-socket", "mt_nonblock: also accept connections on that unix socket path",
+                              cxxopts::value<std::string>());
+        options.add_options()("r,rfifo", "mt_nonblock: also read commands from that FIFO",
+                              cxxopts::value<std::string>());
+        options.add_options()("w,wfifo", "mt_nonblock: write responses to commands from rfifo to that FIFO",
+                              cxxopts::value<std::string>());
+        options.add_options()("udp-port", "mt_nonblock: also serve memcached UDP requests on that port",
+                              cxxopts::value<uint16_t>());
+        options.add_options()("handover",
+                              "mt_nonblock: let new process take listening sockets over by that control socket, "
+                              "SIGUSR2 starts one",
+                              cxxopts::value<std::string>());
+        options.add_options()("takeover", "mt_nonblock: take listening sockets over from process at that control socket",
+                              cxxopts::value<std::string>());
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -161,16 +425,29 @@ int main(int argc, char **argv) {
 
         sigaction(SIGINT, &act, NULL);
         sigaction(SIGTERM, &act, NULL);
+
+        act.sa_sigaction = on_restart;
+        sigaction(SIGUSR2, &act, NULL);
     }
 
     // Run app
     try {
         // Start services
-        app.Start();
+        // Once new process has taken over, this one stops just like on SIGTERM
+        app.Start([]() {
+            stop_reason = SIGTERM;
+            sem_post(&stop_semaphore);
+        });
 
         // Freeze main thread until one of signals arrive
-        while (stop_reason == 0 && ((sem_wait(&stop_semaphore) == -1) && (errno == EINTR))) {
-            continue;
+        while (stop_reason == 0) {
+            if (sem_wait(&stop_semaphore) == -1 && errno == EINTR) {
+                continue;
+            }
+            if (restart_requested) {
+                restart_requested = 0;
+                app.Restart(argv);
+            }
         }
 
         // Stop services
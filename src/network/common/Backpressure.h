@@ -0,0 +1,43 @@
+#ifndef AFINA_NETWORK_COMMON_BACKPRESSURE_H
+#define AFINA_NETWORK_COMMON_BACKPRESSURE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * Connection stops to read new commands once its output queue gets above high watermark, so client that
+ * doesn't read responses can't make server to buffer them forever. Reading resumes when output drains
+ * below low watermark
+ */
+const std::size_t kOutputHighWatermark = 256 * 1024;
+const std::size_t kOutputLowWatermark = 64 * 1024;
+
+/**
+ * Output could still outgrow high watermark by a single huge response. Client is disconnected once its
+ * output queue gets above that limit
+ */
+const std::size_t kOutputHardLimit = 16 * 1024 * 1024;
+
+/**
+ * # Backpressure counters
+ * Shared by connections of one event loop, updated by its thread only but could be read by any
+ */
+struct BackpressureStats {
+    // Times connection stopped reading because of high watermark
+    std::atomic<uint64_t> paused{0};
+
+    // Times connection resumed reading after output drained
+    std::atomic<uint64_t> resumed{0};
+
+    // Clients disconnected because of hard limit
+    std::atomic<uint64_t> overflows{0};
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_BACKPRESSURE_H
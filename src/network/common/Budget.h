@@ -0,0 +1,30 @@
+#ifndef AFINA_NETWORK_COMMON_BUDGET_H
+#define AFINA_NETWORK_COMMON_BUDGET_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Per wakeup budget of connection
+ * Work connection may do before it yields to others served by the same event loop. Client pipelining
+ * thousands of commands gets served in portions, so it can't starve the rest. Connection which spent
+ * its budget with data still pending is served again on the next loop iteration, even if epoll reports
+ * nothing new for it.
+ *
+ * Zero disables corresponding limit
+ */
+struct Budget {
+    // Commands executed
+    uint32_t commands = 64;
+
+    // Bytes read from socket
+    std::size_t bytes = 64 * 1024;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_BUDGET_H
@@ -0,0 +1,48 @@
+#include "ChunkPool.h"
+
+#include <algorithm>
+#include <new>
+
+namespace Afina {
+namespace Network {
+
+// See ChunkPool.h
+ChunkPool::ChunkPool(std::size_t block_size, std::size_t max_free)
+    : _block_size(std::max(block_size, sizeof(free_block))), _max_free(max_free), _free(nullptr), _free_count(0) {}
+
+// See ChunkPool.h
+ChunkPool::~ChunkPool() {
+    while (_free != nullptr) {
+        free_block *next = _free->next;
+        ::operator delete(_free);
+        _free = next;
+    }
+}
+
+// See ChunkPool.h
+void *ChunkPool::get() {
+    if (_free == nullptr) {
+        return ::operator new(_block_size);
+    }
+
+    free_block *block = _free;
+    _free = block->next;
+    _free_count--;
+    return block;
+}
+
+// See ChunkPool.h
+void ChunkPool::put(void *block) {
+    if (_free_count >= _max_free) {
+        ::operator delete(block);
+        return;
+    }
+
+    free_block *fb = static_cast<free_block *>(block);
+    fb->next = _free;
+    _free = fb;
+    _free_count++;
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,55 @@
+#ifndef AFINA_NETWORK_COMMON_CHUNK_POOL_H
+#define AFINA_NETWORK_COMMON_CHUNK_POOL_H
+
+#include <cstddef>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Pool of fixed size memory blocks
+ * Free list of blocks shared by all connections of one event loop, so buffers taken for one response
+ * get reused by the next one instead of going back to the heap.
+ *
+ * Not threadsafe, must be used by the thread owning event loop only
+ */
+class ChunkPool {
+public:
+    /**
+     * @param block_size size of each block
+     * @param max_free number of free blocks to keep, the rest goes back to the heap
+     */
+    explicit ChunkPool(std::size_t block_size = 4096, std::size_t max_free = 1024);
+    ~ChunkPool();
+
+    std::size_t block_size() const { return _block_size; }
+
+    /**
+     * Returns block of block_size() bytes
+     */
+    void *get();
+
+    /**
+     * Returns block to the pool
+     */
+    void put(void *block);
+
+private:
+    ChunkPool(const ChunkPool &) = delete;
+    ChunkPool &operator=(const ChunkPool &) = delete;
+
+    struct free_block {
+        free_block *next;
+    };
+
+    const std::size_t _block_size;
+    const std::size_t _max_free;
+
+    free_block *_free;
+    std::size_t _free_count;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_CHUNK_POOL_H
@@ -0,0 +1,238 @@
+#include "Handover.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+namespace Afina {
+namespace Network {
+
+namespace {
+
+// Most sockets passed at once
+const std::size_t kMaxSockets = 64;
+
+// Seconds new process waits for sockets and old one waits for confirmation
+const int kTimeout = 30;
+
+struct sockaddr_un Address(const std::string &path) {
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Control socket path is too long: " + path);
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+    return addr;
+}
+
+void SetTimeout(int socket) {
+    struct timeval tv;
+    tv.tv_sec = kTimeout;
+    tv.tv_usec = 0;
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+} // namespace
+
+// See Handover.h
+Handover::Handover(const std::string &path, std::shared_ptr<spdlog::logger> logger)
+    : _path(path), _logger(logger), _peer(-1), _control(-1), _inode(0) {}
+
+// See Handover.h
+Handover::~Handover() {
+    Stop();
+    if (_peer != -1) {
+        close(_peer);
+    }
+}
+
+// See Handover.h
+std::vector<int> Handover::Take() {
+    struct sockaddr_un addr = Address(_path);
+    int peer = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (peer == -1) {
+        throw std::runtime_error("Failed to open control socket: " + std::string(strerror(errno)));
+    }
+
+    if (connect(peer, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        close(peer);
+        throw std::runtime_error("Nobody to take over at " + _path + ": " + std::string(strerror(errno)));
+    }
+    SetTimeout(peer);
+
+    char tag;
+    struct iovec iov;
+    iov.iov_base = &tag;
+    iov.iov_len = 1;
+
+    union {
+        char buf[CMSG_SPACE(kMaxSockets * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(peer, &msg, MSG_CMSG_CLOEXEC);
+    if (n != 1) {
+        close(peer);
+        throw std::runtime_error("Failed to receive listening sockets from " + _path);
+    }
+
+    std::vector<int> sockets;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            std::size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int *fds = reinterpret_cast<const int *>(CMSG_DATA(cmsg));
+            sockets.insert(sockets.end(), fds, fds + count);
+        }
+    }
+    if (msg.msg_flags & MSG_CTRUNC) {
+        _logger->warn("Some of listening sockets have been lost on the way");
+    }
+
+    _peer = peer;
+    _logger->warn("Got {} listening sockets from {}", sockets.size(), _path);
+    return sockets;
+}
+
+// See Handover.h
+void Handover::Confirm() {
+    if (_peer == -1) {
+        return;
+    }
+
+    char tag = 'C';
+    if (write(_peer, &tag, 1) != 1) {
+        _logger->error("Failed to confirm takeover: {}", strerror(errno));
+    }
+    close(_peer);
+    _peer = -1;
+}
+
+// See Handover.h
+void Handover::Serve(std::function<std::vector<int>()> listening, std::function<void()> done) {
+    struct sockaddr_un addr = Address(_path);
+    _listening = listening;
+    _done = done;
+
+    // Path is most likely bound by the process this one took over, it won't be reached there anymore
+    struct stat st;
+    if (lstat(_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(_path.c_str());
+    }
+
+    _control = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (_control == -1) {
+        throw std::runtime_error("Failed to open control socket: " + std::string(strerror(errno)));
+    }
+
+    if (bind(_control, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(_control, 1) == -1 ||
+        stat(_path.c_str(), &st) == -1) {
+        std::string error = strerror(errno);
+        close(_control);
+        _control = -1;
+        throw std::runtime_error("Failed to listen on control socket " + _path + ": " + error);
+    }
+    _inode = st.st_ino;
+
+    _thread = std::thread(&Handover::OnRun, this);
+}
+
+// See Handover.h
+void Handover::Stop() {
+    if (_control == -1) {
+        return;
+    }
+
+    // Wakes up control thread blocked in accept
+    shutdown(_control, SHUT_RDWR);
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    close(_control);
+    _control = -1;
+
+    struct stat st;
+    if (stat(_path.c_str(), &st) == 0 && st.st_ino == _inode) {
+        unlink(_path.c_str());
+    }
+}
+
+// See Handover.h
+void Handover::OnRun() {
+    for (;;) {
+        int peer = accept4(_control, nullptr, nullptr, SOCK_CLOEXEC);
+        if (peer == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+
+        std::vector<int> sockets = _listening();
+        if (sockets.empty() || sockets.size() > kMaxSockets) {
+            _logger->error("Can't pass {} listening sockets", sockets.size());
+            close(peer);
+            continue;
+        }
+
+        char tag = 'S';
+        struct iovec iov;
+        iov.iov_base = &tag;
+        iov.iov_len = 1;
+
+        union {
+            char buf[CMSG_SPACE(kMaxSockets * sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        std::memset(&control, 0, sizeof(control));
+
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sockets.size() * sizeof(int));
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sockets.size() * sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), sockets.data(), sockets.size() * sizeof(int));
+
+        if (sendmsg(peer, &msg, MSG_NOSIGNAL) != 1) {
+            _logger->error("Failed to pass listening sockets: {}", strerror(errno));
+            close(peer);
+            continue;
+        }
+        _logger->warn("Passed {} listening sockets, wait for new process to start", sockets.size());
+
+        // Both processes accept connections until new one confirms, nothing is refused meanwhile
+        SetTimeout(peer);
+        ssize_t n = read(peer, &tag, 1);
+        close(peer);
+        if (n == 1) {
+            _logger->warn("New process has taken over");
+            _done();
+            break;
+        }
+        _logger->error("New process failed to take over, keep serving");
+    }
+}
+
+} // namespace Network
+} // namespace Afina
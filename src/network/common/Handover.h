@@ -0,0 +1,85 @@
+#ifndef AFINA_NETWORK_COMMON_HANDOVER_H
+#define AFINA_NETWORK_COMMON_HANDOVER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Listening sockets handover
+ * Lets new process take over the service without a moment nobody accepts connections. Running process
+ * serves control unix socket, new one connects there and gets listening sockets by SCM_RIGHTS. Both
+ * processes accept on them for a while: new one confirms once its server has started, only then the old
+ * one stops and drains. If new process fails or goes away before confirmation, old one keeps serving.
+ *
+ * Control socket is bound to the same path by every generation, so the next restart finds the current one
+ */
+class Handover {
+public:
+    Handover(const std::string &path, std::shared_ptr<spdlog::logger> logger);
+    ~Handover();
+
+    /**
+     * New process side: connects to the running process and receives its listening sockets. Throws
+     * if there is nobody to take over from
+     */
+    std::vector<int> Take();
+
+    /**
+     * New process side: tells the old process its server has started, so the old one could stop
+     */
+    void Confirm();
+
+    /**
+     * Old process side: spawns thread serving control socket. Once some process takes over, done gets
+     * called from that thread and no more requests are served
+     *
+     * @param listening returns sockets to be passed, see Server::Listening()
+     * @param done called once new process confirms it serves
+     */
+    void Serve(std::function<std::vector<int>()> listening, std::function<void()> done);
+
+    /**
+     * Stops serving control socket, removes it unless some newer process has bound the path since then
+     */
+    void Stop();
+
+private:
+    Handover(const Handover &) = delete;
+    Handover &operator=(const Handover &) = delete;
+
+    /**
+     * Method executing by control thread
+     */
+    void OnRun();
+
+    const std::string _path;
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Connection to the old process kept till confirmation
+    int _peer;
+
+    // Control socket and inode of the file it is bound to
+    int _control;
+    ino_t _inode;
+
+    std::function<std::vector<int>()> _listening;
+    std::function<void()> _done;
+    std::thread _thread;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_HANDOVER_H
@@ -0,0 +1,88 @@
+#include "InputBuffer.h"
+
+#include <cassert>
+
+namespace Afina {
+namespace Network {
+
+// See InputBuffer.h
+InputBuffer::InputBuffer(ChunkPool &pool) : _pool(pool), _head(nullptr), _tail(nullptr), _size(0) {
+    assert(pool.block_size() > sizeof(chunk));
+}
+
+// See InputBuffer.h
+InputBuffer::~InputBuffer() { clear(); }
+
+// See InputBuffer.h
+char *InputBuffer::prepare(std::size_t &size) {
+    if (_tail == nullptr || _tail->write == _tail->end) {
+        chunk *c = static_cast<chunk *>(_pool.get());
+        c->next = nullptr;
+        c->read = c->write = reinterpret_cast<char *>(c + 1);
+        c->end = reinterpret_cast<char *>(c) + _pool.block_size();
+        if (_tail == nullptr) {
+            _head = _tail = c;
+        } else {
+            _tail->next = c;
+            _tail = c;
+        }
+    }
+
+    size = _tail->end - _tail->write;
+    return _tail->write;
+}
+
+// See InputBuffer.h
+void InputBuffer::commit(std::size_t n) {
+    assert(_tail != nullptr && _tail->write + n <= _tail->end);
+    _tail->write += n;
+    _size += n;
+}
+
+// See InputBuffer.h
+const char *InputBuffer::peek(std::size_t &size) const {
+    if (_size == 0) {
+        size = 0;
+        return nullptr;
+    }
+
+    size = _head->write - _head->read;
+    return _head->read;
+}
+
+// See InputBuffer.h
+void InputBuffer::consume(std::size_t n) {
+    assert(n <= _size);
+    _size -= n;
+    if (_size == 0) {
+        clear();
+        return;
+    }
+
+    while (n > 0) {
+        std::size_t available = _head->write - _head->read;
+        if (n < available) {
+            _head->read += n;
+            return;
+        }
+
+        n -= available;
+        chunk *drained = _head;
+        _head = _head->next;
+        _pool.put(drained);
+    }
+}
+
+// See InputBuffer.h
+void InputBuffer::clear() {
+    while (_head != nullptr) {
+        chunk *next = _head->next;
+        _pool.put(_head);
+        _head = next;
+    }
+    _tail = nullptr;
+    _size = 0;
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,87 @@
+#ifndef AFINA_NETWORK_COMMON_INPUT_BUFFER_H
+#define AFINA_NETWORK_COMMON_INPUT_BUFFER_H
+
+#include <cstddef>
+
+#include "ChunkPool.h"
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Chained input buffer
+ * Bytes received from the socket but not processed yet. Data is kept in a chain of blocks taken from
+ * the pool: socket reads go to the tail of the last block, consumer takes bytes from the head of the
+ * first one. Consumed bytes are never moved, so input of any size could be buffered and processing a
+ * pipeline of small commands costs nothing but cursor updates.
+ *
+ * Drained blocks go back to the pool right away, so buffer of idle connection holds no memory.
+ *
+ * Not threadsafe
+ */
+class InputBuffer {
+public:
+    explicit InputBuffer(ChunkPool &pool);
+    ~InputBuffer();
+
+    /**
+     * Returns free space at the tail to read into, at least one byte. New block gets linked if the last
+     * one is full or there is none. Bytes written there become visible only after commit()
+     *
+     * @param size output parameter, number of bytes available at returned address
+     */
+    char *prepare(std::size_t &size);
+
+    /**
+     * Appends n bytes placed at address returned by the last prepare() call
+     */
+    void commit(std::size_t n);
+
+    /**
+     * Returns the longest continuous block of unprocessed bytes, or nullptr if buffer is empty
+     *
+     * @param size output parameter, number of bytes in the block
+     */
+    const char *peek(std::size_t &size) const;
+
+    /**
+     * Drops n bytes from the head, n must not exceed size()
+     */
+    void consume(std::size_t n);
+
+    /**
+     * Number of unprocessed bytes
+     */
+    std::size_t size() const { return _size; }
+
+    bool empty() const { return _size == 0; }
+
+    /**
+     * Drops all the data, blocks go back to the pool
+     */
+    void clear();
+
+private:
+    InputBuffer(const InputBuffer &) = delete;
+    InputBuffer &operator=(const InputBuffer &) = delete;
+
+    // Block header, data follows right after it
+    struct chunk {
+        chunk *next;
+        char *read;
+        char *write;
+        char *end;
+    };
+
+    ChunkPool &_pool;
+
+    chunk *_head;
+    chunk *_tail;
+
+    std::size_t _size;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_INPUT_BUFFER_H
@@ -0,0 +1,38 @@
+#ifndef AFINA_NETWORK_COMMON_LISTENERS_H
+#define AFINA_NETWORK_COMMON_LISTENERS_H
+
+#include <cstdint>
+#include <string>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Additional listeners
+ * Endpoints served next to the TCP port. Unix socket and FIFOs are for clients running on the same host
+ * and are served by the same connections as TCP. UDP port takes memcached UDP requests, see UdpEndpoint.h.
+ *
+ * FIFO pair is a single endless connection: server holds both ends of each FIFO, so clients come and go
+ * without server noticing, and responses go out in the order commands came in. If only the FIFO to read
+ * from is given, commands are executed but responses are dropped.
+ *
+ * Empty path disables corresponding listener
+ */
+struct Listeners {
+    // Unix domain stream socket, created on start and removed on stop
+    std::string unix_socket;
+
+    // FIFO server reads commands from, created if missing
+    std::string rfifo;
+
+    // FIFO server writes responses to, created if missing
+    std::string wfifo;
+
+    // UDP port, 0 if none
+    uint16_t udp_port = 0;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_LISTENERS_H
@@ -0,0 +1,104 @@
+#ifndef AFINA_NETWORK_COMMON_MPSC_QUEUE_H
+#define AFINA_NETWORK_COMMON_MPSC_QUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Bounded lock free queue
+ * Any number of threads could push, single one pops. Ring of cells, each cell has sequence number
+ * telling whether it waits for producer or consumer of the given lap, so producers only race for the
+ * tail position and never block each other or the consumer.
+ *
+ * T must be cheap to copy, values are copied into the ring and out of it
+ */
+template <typename T> class MpscQueue {
+public:
+    /**
+     * @param capacity maximum number of queued values, must be a power of two
+     */
+    explicit MpscQueue(std::size_t capacity) : _cells(new cell[capacity]), _mask(capacity - 1), _tail(0), _head(0) {
+        assert(capacity > 0 && (capacity & _mask) == 0);
+        for (std::size_t i = 0; i < capacity; i++) {
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Appends value, returns false if queue is full. Safe to call from any thread
+     */
+    bool push(const T &value) {
+        std::size_t pos = _tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell &c = _cells[pos & _mask];
+            std::size_t seq = c.seq.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+            if (diff == 0) {
+                // Cell is free on this lap, take the position
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = value;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // Consumer hasn't freed the cell since previous lap
+                return false;
+            } else {
+                // Other producer took the position
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Takes the oldest value out, returns false if queue is empty. Consumer thread only
+     */
+    bool pop(T &value) {
+        std::size_t pos = _head.load(std::memory_order_relaxed);
+        cell &c = _cells[pos & _mask];
+        if (c.seq.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+
+        value = c.value;
+        c.seq.store(pos + _mask + 1, std::memory_order_release);
+        _head.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * Approximate number of queued values, could be read by any thread
+     */
+    std::size_t size() const {
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+private:
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    struct cell {
+        std::atomic<std::size_t> seq;
+        T value;
+    };
+
+    std::unique_ptr<cell[]> _cells;
+    const std::size_t _mask;
+
+    // Producers and consumer positions live on separate cache lines
+    std::atomic<std::size_t> _tail;
+    char _pad[64];
+    std::atomic<std::size_t> _head;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_MPSC_QUEUE_H
@@ -0,0 +1,102 @@
+#ifndef AFINA_NETWORK_COMMON_OBJECT_POOL_H
+#define AFINA_NETWORK_COMMON_OBJECT_POOL_H
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Slab pool of objects
+ * Objects are placed into slots of big slabs instead of separate heap blocks. Destroyed object's slot
+ * goes to the free list and gets reused by the next make(). Slabs are never returned to the heap, pool
+ * memory follows the peak number of live objects.
+ *
+ * Not threadsafe
+ */
+template <typename T> class ObjectPool {
+public:
+    /**
+     * @param slab_size number of objects in each slab
+     */
+    explicit ObjectPool(std::size_t slab_size = 256) : _slab_size(slab_size), _free(nullptr), _size(0) {}
+
+    /**
+     * Releases slabs, all objects must be destroyed by then
+     */
+    ~ObjectPool() {}
+
+    /**
+     * Constructs new object in a free slot
+     */
+    template <typename... Args> T *make(Args &&... args) {
+        if (_free == nullptr) {
+            grow();
+        }
+
+        // Object overwrites free list link, so take slot out of the list first
+        slot *s = _free;
+        _free = s->next;
+        try {
+            T *result = new (s->storage) T(std::forward<Args>(args)...);
+            _size++;
+            return result;
+        } catch (...) {
+            s->next = _free;
+            _free = s;
+            throw;
+        }
+    }
+
+    /**
+     * Destroys object created by make() and releases its slot
+     */
+    void destroy(T *p) {
+        p->~T();
+        slot *s = reinterpret_cast<slot *>(p);
+        s->next = _free;
+        _free = s;
+        _size--;
+    }
+
+    /**
+     * Number of live objects
+     */
+    std::size_t size() const { return _size; }
+
+private:
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    union slot {
+        slot *next;
+        alignas(T) char storage[sizeof(T)];
+    };
+
+    void grow() {
+        _slabs.emplace_back(new slot[_slab_size]);
+        slot *slab = _slabs.back().get();
+        for (std::size_t i = 0; i < _slab_size; i++) {
+            slab[i].next = _free;
+            _free = &slab[i];
+        }
+    }
+
+    const std::size_t _slab_size;
+
+    std::vector<std::unique_ptr<slot[]>> _slabs;
+
+    slot *_free;
+
+    std::size_t _size;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_OBJECT_POOL_H
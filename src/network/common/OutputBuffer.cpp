@@ -0,0 +1,109 @@
+#include "OutputBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+
+#include <limits.h>
+#include <sys/uio.h>
+
+namespace Afina {
+namespace Network {
+
+namespace {
+
+// Blocks flushed by the single writev. Socket send buffer is exhausted long before that many blocks
+// get written, so there is no point to build IOV_MAX long vector on the stack
+const int kMaxIov = IOV_MAX < 64 ? IOV_MAX : 64;
+
+} // namespace
+
+// See OutputBuffer.h
+OutputBuffer::OutputBuffer(ChunkPool &pool) : _pool(pool), _head(nullptr), _tail(nullptr), _size(0) {
+    assert(pool.block_size() > sizeof(chunk));
+}
+
+// See OutputBuffer.h
+OutputBuffer::~OutputBuffer() { clear(); }
+
+// See OutputBuffer.h
+void OutputBuffer::append(const char *data, std::size_t size) {
+    _size += size;
+    while (size > 0) {
+        if (_tail == nullptr || _tail->write == _tail->end) {
+            chunk *c = static_cast<chunk *>(_pool.get());
+            c->next = nullptr;
+            c->read = c->write = reinterpret_cast<char *>(c + 1);
+            c->end = reinterpret_cast<char *>(c) + _pool.block_size();
+            if (_tail == nullptr) {
+                _head = _tail = c;
+            } else {
+                _tail->next = c;
+                _tail = c;
+            }
+        }
+
+        std::size_t to_copy = std::min(size, std::size_t(_tail->end - _tail->write));
+        std::memcpy(_tail->write, data, to_copy);
+        _tail->write += to_copy;
+        data += to_copy;
+        size -= to_copy;
+    }
+}
+
+// See OutputBuffer.h
+ssize_t OutputBuffer::write(int fd) {
+    struct iovec iov[kMaxIov];
+    int iovcnt = 0;
+    for (chunk *c = _head; c != nullptr && iovcnt < kMaxIov; c = c->next) {
+        iov[iovcnt].iov_base = c->read;
+        iov[iovcnt].iov_len = c->write - c->read;
+        iovcnt++;
+    }
+
+    if (iovcnt == 0) {
+        return 0;
+    }
+
+    ssize_t written = writev(fd, iov, iovcnt);
+    if (written > 0) {
+        consume(written);
+    }
+    return written;
+}
+
+// See OutputBuffer.h
+void OutputBuffer::clear() {
+    while (_head != nullptr) {
+        chunk *next = _head->next;
+        _pool.put(_head);
+        _head = next;
+    }
+    _tail = nullptr;
+    _size = 0;
+}
+
+void OutputBuffer::consume(std::size_t n) {
+    assert(n <= _size);
+    _size -= n;
+    while (n > 0) {
+        std::size_t available = _head->write - _head->read;
+        if (n < available) {
+            _head->read += n;
+            return;
+        }
+
+        n -= available;
+        chunk *drained = _head;
+        _head = _head->next;
+        _pool.put(drained);
+    }
+
+    if (_head == nullptr) {
+        _tail = nullptr;
+    }
+}
+
+} // namespace Network
+} // namespace Afina
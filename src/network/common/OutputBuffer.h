@@ -0,0 +1,80 @@
+#ifndef AFINA_NETWORK_COMMON_OUTPUT_BUFFER_H
+#define AFINA_NETWORK_COMMON_OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <string>
+
+#include <sys/types.h>
+
+#include "ChunkPool.h"
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Chained output buffer
+ * Responses waiting to be sent to the client. Data is copied into a chain of blocks taken from the pool,
+ * so queueing response costs no allocation once the pool is warm. Whole chain is flushed by the single
+ * writev, partial write just moves cursor in the first block.
+ *
+ * Buffer touches the pool only when data gets in or out, so it could be created and destroyed empty
+ * by any thread.
+ *
+ * Not threadsafe
+ */
+class OutputBuffer {
+public:
+    explicit OutputBuffer(ChunkPool &pool);
+    ~OutputBuffer();
+
+    /**
+     * Appends size bytes to the tail
+     */
+    void append(const char *data, std::size_t size);
+
+    void append(const std::string &data) { append(data.data(), data.size()); }
+
+    /**
+     * Writes as much as possible to the descriptor in one writev call and drops written bytes.
+     * Returns writev result, errno is preserved on error
+     */
+    ssize_t write(int fd);
+
+    /**
+     * Number of bytes waiting to be written
+     */
+    std::size_t size() const { return _size; }
+
+    bool empty() const { return _size == 0; }
+
+    /**
+     * Drops all the data, blocks go back to the pool
+     */
+    void clear();
+
+private:
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    // Block header, data follows right after it
+    struct chunk {
+        chunk *next;
+        char *read;
+        char *write;
+        char *end;
+    };
+
+    void consume(std::size_t n);
+
+    ChunkPool &_pool;
+
+    chunk *_head;
+    chunk *_tail;
+
+    std::size_t _size;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_OUTPUT_BUFFER_H
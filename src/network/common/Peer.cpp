@@ -0,0 +1,38 @@
+#include "Peer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace Afina {
+namespace Network {
+
+// See Peer.h
+std::string PeerName(int socket) {
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getpeername(socket, reinterpret_cast<struct sockaddr *>(&addr), &len) == -1) {
+        return "unknown";
+    }
+
+    char host[INET6_ADDRSTRLEN];
+    switch (addr.ss_family) {
+    case AF_INET: {
+        const struct sockaddr_in *in = reinterpret_cast<const struct sockaddr_in *>(&addr);
+        inet_ntop(AF_INET, &in->sin_addr, host, sizeof(host));
+        return std::string(host) + ":" + std::to_string(ntohs(in->sin_port));
+    }
+    case AF_INET6: {
+        const struct sockaddr_in6 *in6 = reinterpret_cast<const struct sockaddr_in6 *>(&addr);
+        inet_ntop(AF_INET6, &in6->sin6_addr, host, sizeof(host));
+        return "[" + std::string(host) + "]:" + std::to_string(ntohs(in6->sin6_port));
+    }
+    case AF_UNIX:
+        return "unix";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,18 @@
+#ifndef AFINA_NETWORK_COMMON_PEER_H
+#define AFINA_NETWORK_COMMON_PEER_H
+
+#include <string>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * Numeric address of the socket peer as "host:port", "unix" for unix domain sockets. Address is asked from
+ * kernel right here, so accept path doesn't keep it and pays for formatting only when it is really written
+ */
+std::string PeerName(int socket);
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_PEER_H
@@ -0,0 +1,17 @@
+#include "StatsStorage.h"
+
+#include <afina/network/Server.h>
+
+namespace Afina {
+namespace Network {
+
+// See StatsStorage.h
+void StatsStorage::Stats(std::vector<std::pair<std::string, std::size_t>> &stats) const {
+    _storage->Stats(stats);
+    if (_server != nullptr) {
+        _server->Stats(stats);
+    }
+}
+
+} // namespace Network
+} // namespace Afina
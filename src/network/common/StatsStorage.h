@@ -0,0 +1,57 @@
+#ifndef AFINA_NETWORK_COMMON_STATS_STORAGE_H
+#define AFINA_NETWORK_COMMON_STATS_STORAGE_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+
+namespace Afina {
+namespace Network {
+
+class Server;
+
+/**
+ * # Storage reporting network counters
+ * Commands see nothing but the storage, so server counters get to the "stats" command through it. Every
+ * call goes to the wrapped storage, Stats appends counters of the attached server to the storage ones.
+ */
+class StatsStorage : public Afina::Storage {
+public:
+    explicit StatsStorage(std::shared_ptr<Afina::Storage> storage) : _storage(storage), _server(nullptr) {}
+    ~StatsStorage() {}
+
+    /**
+     * Server to report counters of, must be attached before it starts and outlive its connections
+     */
+    void Attach(const Server *server) { _server = server; }
+
+    void Start() override { _storage->Start(); }
+    void Stop() override { _storage->Stop(); }
+
+    bool Put(const std::string &key, const std::string &value) override { return _storage->Put(key, value); }
+
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return _storage->PutIfAbsent(key, value);
+    }
+
+    bool Set(const std::string &key, const std::string &value) override { return _storage->Set(key, value); }
+
+    bool Delete(const std::string &key) override { return _storage->Delete(key); }
+
+    bool Get(const std::string &key, std::string &value) override { return _storage->Get(key, value); }
+
+    void Stats(std::vector<std::pair<std::string, std::size_t>> &stats) const override;
+
+private:
+    std::shared_ptr<Afina::Storage> _storage;
+
+    const Server *_server;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_STATS_STORAGE_H
@@ -0,0 +1,119 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+
+namespace Afina {
+namespace Network {
+
+// See TimerWheel.h
+TimerWheel::TimerWheel(uint64_t now, uint64_t tick) : _tick(tick), _now(now / tick), _size(0), _occupied(0) {
+    assert(tick > 0);
+    for (unsigned level = 0; level < kLevels; level++) {
+        for (unsigned slot = 0; slot < kSlots; slot++) {
+            Timer *head = &_wheel[level][slot];
+            head->prev = head->next = head;
+        }
+    }
+}
+
+// See TimerWheel.h
+TimerWheel::~TimerWheel() {}
+
+// See TimerWheel.h
+void TimerWheel::schedule(Timer *timer, uint64_t expires) {
+    if (timer->armed()) {
+        unlink(timer);
+    }
+
+    // Round up, timer must not fire earlier than asked. Timer that should have fired already goes off
+    // on the next tick, one that is too far away fires at the end of the wheel span
+    const uint64_t span = uint64_t(1) << (kBits * kLevels);
+    timer->expires = std::max((expires + _tick - 1) / _tick, _now + 1);
+    timer->expires = std::min(timer->expires, _now + span - 1);
+    place(timer);
+    _size++;
+}
+
+// See TimerWheel.h
+void TimerWheel::cancel(Timer *timer) {
+    if (timer->armed()) {
+        unlink(timer);
+    }
+}
+
+// See TimerWheel.h
+int TimerWheel::timeout(uint64_t now) const {
+    if (_size == 0) {
+        return -1;
+    }
+
+    // The next tick having timers in the lowest level, or the end of its turn when upper levels cascade
+    uint64_t next = _now + 1;
+    if ((next & kMask) != 0) {
+        uint64_t pending = _occupied & (~uint64_t(0) << (next & kMask));
+        next = pending ? (next & ~kMask) + __builtin_ctzll(pending) : (next | kMask) + 1;
+    }
+
+    uint64_t at = next * _tick;
+    if (at <= now) {
+        return 0;
+    }
+    return int(std::min<uint64_t>(at - now, INT_MAX));
+}
+
+void TimerWheel::step(uint64_t target) {
+    uint64_t next = _now + 1;
+    if ((next & kMask) != 0) {
+        // Skip empty slots till the end of current turn
+        uint64_t pending = _occupied & (~uint64_t(0) << (next & kMask));
+        next = pending ? (next & ~kMask) + __builtin_ctzll(pending) : (next | kMask) + 1;
+        next = std::min(next, target);
+    }
+    _now = next;
+
+    // Lower level made a turn, bring the next slot of upper one down. Upper level turns only once
+    // level below it wraps as well
+    for (unsigned level = 1; level < kLevels && ((_now >> (kBits * (level - 1))) & kMask) == 0; level++) {
+        Timer *head = &_wheel[level][(_now >> (kBits * level)) & kMask];
+        while (head->next != head) {
+            Timer *t = head->next;
+            unlink(t);
+            place(t);
+            _size++;
+        }
+    }
+
+    // Slot of the current tick gets drained by advance() right away
+    _occupied &= ~(uint64_t(1) << (_now & kMask));
+}
+
+void TimerWheel::place(Timer *timer) {
+    // Cascaded timer could expire right on the current tick, it goes to the current slot then
+    uint64_t delta = timer->expires - _now;
+    unsigned level = 0;
+    while (delta >= (uint64_t(1) << (kBits * (level + 1)))) {
+        level++;
+    }
+
+    unsigned slot = (timer->expires >> (kBits * level)) & kMask;
+    Timer *head = &_wheel[level][slot];
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+    if (level == 0) {
+        _occupied |= uint64_t(1) << slot;
+    }
+}
+
+void TimerWheel::unlink(Timer *timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->prev = timer->next = nullptr;
+    _size--;
+}
+
+} // namespace Network
+} // namespace Afina
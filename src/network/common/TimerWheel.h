@@ -0,0 +1,128 @@
+#ifndef AFINA_NETWORK_COMMON_TIMER_WHEEL_H
+#define AFINA_NETWORK_COMMON_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * # Hierarchical timer wheel
+ * Keeps timers of one event loop. Time is split in ticks, each of the kLevels wheels has kSlots slots,
+ * slot of level L spans kSlots^L ticks. Timer is linked into the slot of the lowest level its expiration
+ * fits in, once lower level wheel makes full turn timers of the next slot of upper one cascade down.
+ *
+ * Schedule, reschedule and cancel are O(1), so timer could be moved on every connection activity.
+ * Expiration time is rounded up to the tick, timers further than the wheel span fire at its end.
+ *
+ * Not threadsafe
+ */
+class TimerWheel {
+public:
+    /**
+     * Timer is a part of the owning object, wheel just links it into slots
+     */
+    struct Timer {
+        Timer() : prev(nullptr), next(nullptr), expires(0), data(nullptr) {}
+
+        bool armed() const { return next != nullptr; }
+
+        Timer *prev;
+        Timer *next;
+
+        // Expiration tick
+        uint64_t expires;
+
+        // Owner's data, wheel doesn't touch it
+        void *data;
+    };
+
+    /**
+     * @param now current time in milliseconds
+     * @param tick wheel resolution in milliseconds
+     */
+    TimerWheel(uint64_t now, uint64_t tick = 8);
+
+    /**
+     * Armed timers are left as is, their owners could be destroyed already
+     */
+    ~TimerWheel();
+
+    /**
+     * Arms timer to fire at given time in milliseconds, timer gets moved if armed already
+     */
+    void schedule(Timer *timer, uint64_t expires);
+
+    /**
+     * Disarms timer, does nothing if it isn't armed
+     */
+    void cancel(Timer *timer);
+
+    /**
+     * Returns milliseconds until the wheel needs advance() call, or -1 if there are no timers.
+     * Suitable as epoll_wait timeout
+     */
+    int timeout(uint64_t now) const;
+
+    /**
+     * Moves wheel to the given time and calls on_expire(Timer *) for every timer expired up to it.
+     * Timer is disarmed before the call, so callback could schedule it again or destroy its owner
+     */
+    template <typename F> void advance(uint64_t now, F &&on_expire) {
+        uint64_t target = now / _tick;
+        while (_now < target) {
+            step(target);
+
+            Timer *head = &_wheel[0][_now & kMask];
+            while (head->next != head) {
+                Timer *t = head->next;
+                unlink(t);
+                on_expire(t);
+            }
+        }
+    }
+
+    /**
+     * Number of armed timers
+     */
+    std::size_t size() const { return _size; }
+
+private:
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    static const unsigned kBits = 6;
+    static const unsigned kSlots = 1 << kBits;
+    static const uint64_t kMask = kSlots - 1;
+    static const unsigned kLevels = 4;
+
+    /**
+     * Moves current tick forward to the next one having something to do, but not further than target.
+     * Cascades upper levels if lower one made a turn
+     */
+    void step(uint64_t target);
+
+    // Links timer into the slot according to its expiration tick
+    void place(Timer *timer);
+
+    void unlink(Timer *timer);
+
+    const uint64_t _tick;
+
+    // Last processed tick
+    uint64_t _now;
+
+    std::size_t _size;
+
+    // Slot heads of circular timer lists
+    Timer _wheel[kLevels][kSlots];
+
+    // Bit per non empty slot of the lowest level, lets to skip empty ticks at once
+    uint64_t _occupied;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_TIMER_WHEEL_H
@@ -0,0 +1,48 @@
+#include "Tuning.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+
+namespace {
+
+void Set(int socket, int level, int name, int value, const char *what) {
+    if (setsockopt(socket, level, name, &value, sizeof(value)) == -1) {
+        std::string error = strerror(errno);
+        close(socket);
+        throw std::runtime_error(std::string("Failed to set ") + what + ": " + error);
+    }
+}
+
+} // namespace
+
+// See Tuning.h
+void TuneListening(int socket, const Options &options) {
+    if (options.nodelay) {
+        Set(socket, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+    }
+    if (options.defer_accept > 0) {
+        Set(socket, IPPROTO_TCP, TCP_DEFER_ACCEPT, options.defer_accept, "TCP_DEFER_ACCEPT");
+    }
+    if (options.rcvbuf > 0) {
+        Set(socket, SOL_SOCKET, SO_RCVBUF, options.rcvbuf, "SO_RCVBUF");
+    }
+    if (options.sndbuf > 0) {
+        Set(socket, SOL_SOCKET, SO_SNDBUF, options.sndbuf, "SO_SNDBUF");
+    }
+    if (options.busy_poll > 0) {
+        Set(socket, SOL_SOCKET, SO_BUSY_POLL, options.busy_poll, "SO_BUSY_POLL");
+    }
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,19 @@
+#ifndef AFINA_NETWORK_COMMON_TUNING_H
+#define AFINA_NETWORK_COMMON_TUNING_H
+
+#include <afina/network/Options.h>
+
+namespace Afina {
+namespace Network {
+
+/**
+ * Applies socket tuning of options to TCP listening socket, must be called before listen() as buffer sizes
+ * define window scale negotiated with clients. Closes socket and throws if some option is rejected, the same
+ * way the rest of listening socket setup does
+ */
+void TuneListening(int socket, const Options &options);
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_TUNING_H
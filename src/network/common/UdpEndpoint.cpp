@@ -0,0 +1,217 @@
+#include "UdpEndpoint.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+
+namespace Afina {
+namespace Network {
+
+namespace {
+
+// Datagrams received by single recvmmsg
+const std::size_t kBatch = 64;
+
+// Largest request accepted, bigger ones are rejected
+const std::size_t kMaxRequest = 2048;
+
+// Frame header size and largest response datagram, frames stay below common MTU
+const std::size_t kHeaderSize = 8;
+const std::size_t kMaxDatagram = 1400;
+
+// Messages sendmmsg takes at once
+const std::size_t kMaxSend = 1024;
+
+inline uint16_t get16(const uint8_t *p) { return uint16_t(p[0] << 8 | p[1]); }
+
+inline void put16(uint8_t *p, uint16_t value) {
+    p[0] = uint8_t(value >> 8);
+    p[1] = uint8_t(value);
+}
+
+} // namespace
+
+// See UdpEndpoint.h
+UdpEndpoint::UdpEndpoint(int socket, std::shared_ptr<spdlog::logger> logger, std::shared_ptr<Afina::Storage> storage)
+    : _socket(socket), _logger(logger), _storage(storage), _recv_buffer(kBatch * kMaxRequest), _recv_iov(kBatch),
+      _recv_msgs(kBatch), _recv_addrs(kBatch), _responses(kBatch), _dropped(0) {}
+
+// See UdpEndpoint.h
+UdpEndpoint::~UdpEndpoint() { close(_socket); }
+
+// See UdpEndpoint.h
+std::size_t UdpEndpoint::Serve(std::size_t max_batches) {
+    std::size_t served = 0;
+    for (std::size_t batch = 0; batch < max_batches; batch++) {
+        // Kernel overwrites lengths, so every slot is prepared again
+        for (std::size_t i = 0; i < kBatch; i++) {
+            _recv_iov[i].iov_base = &_recv_buffer[i * kMaxRequest];
+            _recv_iov[i].iov_len = kMaxRequest;
+            std::memset(&_recv_msgs[i], 0, sizeof(struct mmsghdr));
+            _recv_msgs[i].msg_hdr.msg_iov = &_recv_iov[i];
+            _recv_msgs[i].msg_hdr.msg_iovlen = 1;
+            _recv_msgs[i].msg_hdr.msg_name = &_recv_addrs[i];
+            _recv_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+        }
+
+        int n = recvmmsg(_socket, &_recv_msgs[0], kBatch, MSG_DONTWAIT, nullptr);
+        if (n <= 0) {
+            if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                _logger->error("Failed to receive datagrams: {}", strerror(errno));
+            }
+            break;
+        }
+        _logger->debug("Got {} datagrams", n);
+
+        _frames.clear();
+        for (int i = 0; i < n; i++) {
+            const uint8_t *header = reinterpret_cast<const uint8_t *>(&_recv_buffer[i * kMaxRequest]);
+            std::size_t size = _recv_msgs[i].msg_len;
+            std::string &response = _responses[i];
+            response.clear();
+
+            // Not a memcached frame or a part of multi datagram request, there is nobody to answer to
+            if (size < kHeaderSize || get16(header + 4) != 1) {
+                _logger->debug("Drop malformed datagram of {} bytes", size);
+                continue;
+            }
+
+            if (_recv_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                response = "SERVER_ERROR object too large for cache\r\n";
+            } else {
+                Execute(reinterpret_cast<const char *>(header) + kHeaderSize, size - kHeaderSize, response);
+            }
+            Frame(i, response);
+            served++;
+        }
+        Flush();
+
+        // Socket is most likely drained, don't waste a syscall to see EAGAIN
+        if (std::size_t(n) < kBatch) {
+            break;
+        }
+    }
+    return served;
+}
+
+// See UdpEndpoint.h
+void UdpEndpoint::Execute(const char *data, std::size_t size, std::string &out) {
+    while (size > 0) {
+        try {
+            _parser.Reset();
+            std::size_t parsed = 0;
+            if (!_parser.Parse(data, size, parsed)) {
+                out += "CLIENT_ERROR incomplete command\r\n";
+                return;
+            }
+            data += parsed;
+            size -= parsed;
+
+            // Argument must be in the same datagram
+            std::size_t body_size = 0;
+            Protocol::InPlaceCommand command = _parser.BuildInPlace(body_size);
+            std::size_t block_size = _parser.BlockSize();
+            if (size < block_size) {
+                out += "CLIENT_ERROR bad data chunk\r\n";
+                return;
+            }
+            _argument.assign(data, block_size);
+            _parser.StripBlock(_argument);
+            data += block_size;
+            size -= block_size;
+
+            _result.clear();
+            command->Execute(*_storage, _argument, _result);
+            out += _result;
+            out += "\r\n";
+        } catch (std::runtime_error &ex) {
+            // Request is a single datagram, so there is nothing to resync with, the rest is dropped
+            out += "CLIENT_ERROR ";
+            out += ex.what();
+            out += "\r\n";
+            return;
+        }
+    }
+}
+
+// See UdpEndpoint.h
+void UdpEndpoint::Frame(std::size_t i, const std::string &response) {
+    const uint8_t *request = reinterpret_cast<const uint8_t *>(&_recv_buffer[i * kMaxRequest]);
+    std::size_t payload = kMaxDatagram - kHeaderSize;
+    std::size_t total = std::max<std::size_t>(1, (response.size() + payload - 1) / payload);
+    if (total > 0xFFFF) {
+        _logger->error("Response of {} bytes doesn't fit into datagrams, drop it", response.size());
+        _dropped++;
+        return;
+    }
+
+    for (std::size_t seq = 0; seq < total; seq++) {
+        frame f;
+        f.response = i;
+        f.offset = seq * payload;
+        f.size = std::min(payload, response.size() - f.offset);
+        std::memcpy(f.header, request, 2);
+        put16(f.header + 2, uint16_t(seq));
+        put16(f.header + 4, uint16_t(total));
+        put16(f.header + 6, 0);
+        _frames.push_back(f);
+    }
+}
+
+// See UdpEndpoint.h
+void UdpEndpoint::Flush() {
+    if (_frames.empty()) {
+        return;
+    }
+
+    _send_iov.resize(2 * _frames.size());
+    _send_msgs.resize(_frames.size());
+    for (std::size_t j = 0; j < _frames.size(); j++) {
+        frame &f = _frames[j];
+        _send_iov[2 * j].iov_base = f.header;
+        _send_iov[2 * j].iov_len = kHeaderSize;
+        _send_iov[2 * j + 1].iov_base = &_responses[f.response][0] + f.offset;
+        _send_iov[2 * j + 1].iov_len = f.size;
+
+        std::memset(&_send_msgs[j], 0, sizeof(struct mmsghdr));
+        _send_msgs[j].msg_hdr.msg_iov = &_send_iov[2 * j];
+        _send_msgs[j].msg_hdr.msg_iovlen = 2;
+        _send_msgs[j].msg_hdr.msg_name = &_recv_addrs[f.response];
+        _send_msgs[j].msg_hdr.msg_namelen = _recv_msgs[f.response].msg_hdr.msg_namelen;
+    }
+
+    std::size_t sent = 0;
+    while (sent < _send_msgs.size()) {
+        std::size_t count = std::min(kMaxSend, _send_msgs.size() - sent);
+        int n = sendmmsg(_socket, &_send_msgs[sent], count, MSG_DONTWAIT);
+        if (n > 0) {
+            sent += n;
+        } else if (n == -1 && errno == EINTR) {
+            continue;
+        } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Socket buffer is full, waiting for it would hold everyone else
+            break;
+        } else {
+            // Error belongs to the first message only, the rest could still go
+            _logger->debug("Failed to send datagram: {}", strerror(errno));
+            _dropped++;
+            sent++;
+        }
+    }
+
+    if (sent < _send_msgs.size()) {
+        _logger->debug("Drop {} datagrams, socket buffer is full", _send_msgs.size() - sent);
+        _dropped += _send_msgs.size() - sent;
+    }
+}
+
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,115 @@
+#ifndef AFINA_NETWORK_COMMON_UDP_ENDPOINT_H
+#define AFINA_NETWORK_COMMON_UDP_ENDPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <protocol/Parser.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+
+namespace Network {
+
+/**
+ * # memcached UDP frontend
+ * Serves requests coming as UDP datagrams. Every datagram starts with 8 bytes frame header: request id,
+ * sequence number, total number of datagrams and reserved field, all 16 bit in network byte order. Request
+ * must fit into a single datagram, it could carry several commands though. Response of any size is split
+ * into datagrams, each has the same request id, its own sequence number and total count.
+ *
+ * Datagrams are received and sent in batches, one recvmmsg and one sendmmsg per batch. Responses are best
+ * effort just like UDP: ones that don't fit into socket send buffer are dropped.
+ *
+ * Not threadsafe, must be used by the thread owning event loop only
+ */
+class UdpEndpoint {
+public:
+    /**
+     * @param socket non blocking datagram socket, endpoint owns it
+     */
+    UdpEndpoint(int socket, std::shared_ptr<spdlog::logger> logger, std::shared_ptr<Afina::Storage> storage);
+    ~UdpEndpoint();
+
+    int socket() const { return _socket; }
+
+    /**
+     * Serves received datagrams until socket has no more or max_batches batches are served. Returns number
+     * of requests served
+     */
+    std::size_t Serve(std::size_t max_batches);
+
+    /**
+     * Number of response datagrams dropped since endpoint has been created
+     */
+    std::size_t dropped() const { return _dropped; }
+
+private:
+    UdpEndpoint(const UdpEndpoint &) = delete;
+    UdpEndpoint &operator=(const UdpEndpoint &) = delete;
+
+    /**
+     * Executes all commands of the request, appends their results to out
+     */
+    void Execute(const char *data, std::size_t size, std::string &out);
+
+    /**
+     * Splits response to the i-th datagram of the batch into frames
+     */
+    void Frame(std::size_t i, const std::string &response);
+
+    /**
+     * Sends all framed responses of the batch
+     */
+    void Flush();
+
+    int _socket;
+
+    std::shared_ptr<spdlog::logger> _logger;
+    std::shared_ptr<Afina::Storage> _storage;
+
+    // Receive side, one slot per datagram of the batch
+    std::vector<char> _recv_buffer;
+    std::vector<struct iovec> _recv_iov;
+    std::vector<struct mmsghdr> _recv_msgs;
+    std::vector<struct sockaddr_storage> _recv_addrs;
+
+    // Responses to datagrams of the batch
+    std::vector<std::string> _responses;
+
+    // Frames of the responses: which response, part of it and frame header. Messages point into responses
+    // and headers, so they are built once all frames are known
+    struct frame {
+        std::size_t response;
+        std::size_t offset;
+        std::size_t size;
+        uint8_t header[8];
+    };
+    std::vector<frame> _frames;
+    std::vector<struct iovec> _send_iov;
+    std::vector<struct mmsghdr> _send_msgs;
+
+    // Command state, reused by all requests
+    Protocol::Parser _parser;
+    std::string _argument;
+    std::string _result;
+
+    std::size_t _dropped;
+};
+
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_COMMON_UDP_ENDPOINT_H
@@ -1,6 +1,8 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <iostream>
 #include <memory>
@@ -20,6 +22,7 @@
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
+#include <network/common/Tuning.h>
 
 #include "protocol/Parser.h"
 
@@ -27,14 +30,38 @@ namespace Afina {
 namespace Network {
 namespace MTblocking {
 
+namespace {
+
+// Responses queued past that size are sent before the rest of the read is processed
+const std::size_t kFlushThreshold = 64 * 1024;
+
+// Sends all responses queued, more tells kernel the next ones follow shortly so it could hold partial segment
+void Flush(int socket, std::string &output, bool more) {
+    std::size_t sent = 0;
+    while (sent < output.size()) {
+        ssize_t n = send(socket, output.data() + sent, output.size() - sent, more ? MSG_MORE : 0);
+        if (n <= 0) {
+            throw std::runtime_error("Failed to send response");
+        }
+        sent += n;
+    }
+    output.clear();
+}
+
+} // namespace
+
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       uint32_t idle_timeout, uint32_t read_timeout, uint32_t min_threads, uint32_t max_threads,
+                       uint32_t accept_queue)
+    : Server(ps, pl), _idle_timeout(idle_timeout), _read_timeout(read_timeout), _min_threads(min_threads),
+      _max_threads(max_threads), _accept_queue(accept_queue), _server_socket(-1) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
 
 // See Server.h
-void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
+void ServerImpl::Start(const Options &options) {
     _logger = pLogging->select("network");
     _logger->info("Start mt_blocking network service");
 
@@ -47,9 +74,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 
     struct sockaddr_in server_addr;
     std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+    server_addr.sin_family = AF_INET;           // IPv4
+    server_addr.sin_port = htons(options.port); // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY;   // Bind to any address
 
     _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (_server_socket == -1) {
@@ -67,11 +94,17 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Socket bind() failed");
     }
 
-    if (listen(_server_socket, 5) == -1) {
+    TuneListening(_server_socket, options);
+
+    if (listen(_server_socket, options.backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed");
     }
 
+    // Idle threads above minimum are released after a while
+    _executor.reset(new Concurrency::Executor("mt_block", _accept_queue, _max_threads, _min_threads, 10000));
+    _executor->Start();
+
     running.store(true);
     _thread = std::thread(&ServerImpl::OnRun, this);
 }
@@ -80,22 +113,22 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
 void ServerImpl::Stop() {
     running.store(false);
     shutdown(_server_socket, SHUT_RDWR);
+    // Connections finish commands already received and see EOF, queued ones get it right away
     {
         std::lock_guard<std::mutex> lock(_mutex);
-        for (auto &_w : _workers)
-            shutdown(_w.first, SHUT_RD);
+        for (int client_socket : _connections) {
+            shutdown(client_socket, SHUT_RD);
+        }
     }
 }
 
 // See Server.h
 void ServerImpl::Join() {
-    {
-        std::unique_lock<std::mutex> lock(_mutex);
-        while (!_workers.empty())
-            _join_threads.wait(lock);
-    }
     assert(_thread.joinable());
     _thread.join();
+
+    // Acceptor is gone, so no more connections get to the pool
+    _executor->Stop(true);
 }
 
 // See Server.h
@@ -129,43 +162,75 @@ void ServerImpl::OnRun() {
             _logger->debug("Accepted connection on descriptor {} (host={}, port={})\n", client_socket, host, port);
         }
 
-        // Configure read timeout
+        // Connection is registered before it gets to the pool, so Stop could shut down even queued ones
         {
-            struct timeval tv;
-            tv.tv_sec = 5; // TODO: make it configurable
-            tv.tv_usec = 0;
-            setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
+            std::lock_guard<std::mutex> lock(_mutex);
+            _connections.insert(client_socket);
         }
+        if (!running.load() || !_executor->Execute(&ServerImpl::Serve, this, client_socket)) {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _connections.erase(client_socket);
+            }
 
-        // TODO: Start new thread and process data from/to connection
-        try {
-            std::lock_guard<std::mutex> lock(_mutex);
-            if ((_workers.size() >= _max_threads)||(!running.load())) {
-                static const std::string msg = "The limit exceeded";
-                close(client_socket);
-                if (send(client_socket, msg.data(), msg.size(), 0) <= 0)
-                    throw std::runtime_error("Failed to send response");
-            } else {
-                _workers.emplace(client_socket, std::thread(&ServerImpl::RUN, this, client_socket));
+            // Client may not read at all, acceptor must not block on it
+            static const std::string msg = "SERVER_ERROR too many connections\r\n";
+            if (send(client_socket, msg.data(), msg.size(), MSG_DONTWAIT | MSG_NOSIGNAL) <= 0) {
+                _logger->debug("Failed to send rejection to descriptor {}", client_socket);
             }
-        } catch (std::runtime_error &ex) {
-            _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+            _logger->warn("Reject connection on descriptor {}: all threads are busy", client_socket);
+            close(client_socket);
         }
     }
     close(_server_socket);
     // Cleanup on exit...
     _logger->warn("Network stopped");
 }
-void ServerImpl::RUN(int client_socket) {
+
+// See ServerImpl.h
+void ServerImpl::Serve(int client_socket) {
     std::size_t arg_remains;
     Protocol::Parser parser;
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
-
+    Protocol::InPlaceCommand command_to_execute;
+    // Reused by all commands of the connection to keep its capacity
+    std::string result;
+
+    // Connection waits for a new request no longer than idle timeout, once request is started it must
+    // be received till the deadline. Socket receive timeout is updated only if it differs from the current one
+    bool in_request = false;
+    std::chrono::steady_clock::time_point deadline;
+    uint32_t receive_timeout = 0;
+
+    // Responses not sent yet
+    std::string output;
     try {
         int readed_bytes = -1;
         char client_buffer[4096];
-        while ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) > 0) {
+        for (;;) {
+            uint32_t timeout = _idle_timeout;
+            bool started = command_to_execute || !parser.Name().empty();
+            if (started && _read_timeout > 0) {
+                auto now = std::chrono::steady_clock::now();
+                if (!in_request) {
+                    deadline = now + std::chrono::milliseconds(_read_timeout);
+                }
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+                timeout = uint32_t(std::max<decltype(left)>(left, 1));
+            }
+            in_request = started;
+
+            if (timeout != receive_timeout) {
+                struct timeval tv;
+                tv.tv_sec = timeout / 1000;
+                tv.tv_usec = (timeout % 1000) * 1000;
+                setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof tv);
+                receive_timeout = timeout;
+            }
+
+            if ((readed_bytes = read(client_socket, client_buffer, sizeof(client_buffer))) <= 0) {
+                break;
+            }
             _logger->debug("Got {} bytes from socket", readed_bytes);
 
             // Single block of data readed from the socket could trigger inside actions a multiple times,
@@ -181,10 +246,8 @@ void ServerImpl::RUN(int client_socket) {
                         // There is no command to be launched, continue to parse input stream
                         // Here we are, current chunk finished some command, process it
                         _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
-                        command_to_execute = parser.Build(arg_remains);
-                        if (arg_remains > 0) {
-                            arg_remains += 2;
-                        }
+                        command_to_execute = parser.BuildInPlace(arg_remains);
+                        arg_remains = parser.BlockSize();
                     }
 
                     // Parsed might fails to consume any bytes from input stream. In real life that could happens,
@@ -213,13 +276,16 @@ void ServerImpl::RUN(int client_socket) {
                 if (command_to_execute && arg_remains == 0) {
                     _logger->debug("Start command execution");
 
-                    std::string result;
+                    parser.StripBlock(argument_for_command);
+
+                    result.clear();
                     command_to_execute->Execute(*pStorage, argument_for_command, result);
 
-                    // Send response
-                    result += "\r\n";
-                    if (send(client_socket, result.data(), result.size(), 0) <= 0) {
-                        throw std::runtime_error("Failed to send response");
+                    // Responses of commands from one read go out together
+                    output += result;
+                    output += "\r\n";
+                    if (output.size() >= kFlushThreshold) {
+                        Flush(client_socket, output, readed_bytes > 0);
                     }
 
                     // Prepare for the next command
@@ -228,28 +294,30 @@ void ServerImpl::RUN(int client_socket) {
                     parser.Reset();
                 }
             } // while (readed_bytes)
+            Flush(client_socket, output, false);
         }
 
         if (readed_bytes == 0) {
             _logger->debug("Connection closed");
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            _logger->debug("Connection on descriptor {} timed out", client_socket);
         } else {
             throw std::runtime_error(std::string(strerror(errno)));
         }
     } catch (std::runtime_error &ex) {
         _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
-    }
-
 
+        // Commands executed before the failure still get their responses
+        if (!output.empty()) {
+            send(client_socket, output.data(), output.size(), MSG_NOSIGNAL);
+        }
+    }
 
     // Prepare for the next command: just in case if connection was closed in the middle of executing something
     {
         std::lock_guard<std::mutex> lock(_mutex);
-        auto it = _workers.find(client_socket);
-        it->second.detach();
-        _workers.erase(it);
+        _connections.erase(client_socket);
         close(client_socket);
-        if ((_workers.size() == 0) && !running.load())
-            _join_threads.notify_all();
     }
 }
 } // namespace MTblocking
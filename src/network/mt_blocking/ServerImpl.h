@@ -2,11 +2,12 @@
 #define AFINA_NETWORK_MT_BLOCKING_SERVER_H
 
 #include <atomic>
-#include <condition_variable>
-#include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_set>
 
+#include <afina/concurrency/Executor.h>
 #include <afina/network/Server.h>
 
 namespace spdlog {
@@ -19,15 +20,26 @@ namespace MTblocking {
 
 /**
  * # Network resource manager implementation
- * Server that is spawning a separate thread for each connection
+ * Server serving each connection by blocking IO in a thread of the pool. Pool keeps min_threads
+ * threads ready and grows up to max_threads, connections accepted while all threads are busy wait for
+ * a free one in the queue of accept_queue size. Connection that doesn't fit is rejected with error
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    /**
+     * @param idle_timeout milliseconds connection could wait for a new request, 0 for no limit
+     * @param read_timeout milliseconds started request must be received in, 0 for no limit
+     * @param min_threads threads kept alive while there are no connections
+     * @param max_threads maximum number of connections served at once
+     * @param accept_queue maximum number of connections waiting for a free thread
+     */
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               uint32_t idle_timeout = 5000, uint32_t read_timeout = 0, uint32_t min_threads = 4,
+               uint32_t max_threads = 64, uint32_t accept_queue = 64);
     ~ServerImpl();
 
     // See Server.h
-    void Start(uint16_t port, uint32_t, uint32_t) override;
+    void Start(const Options &options) override;
 
     // See Server.h
     void Stop() override;
@@ -41,6 +53,11 @@ protected:
      */
     void OnRun();
 
+    /**
+     * Serves connection till it gets closed, runs in the pool thread
+     */
+    void Serve(int client_socket);
+
 private:
     // Logger instance
     std::shared_ptr<spdlog::logger> _logger;
@@ -50,16 +67,27 @@ private:
     // bounds
     std::atomic<bool> running;
 
+    // Connection timeouts in milliseconds, 0 if disabled
+    uint32_t _idle_timeout;
+    uint32_t _read_timeout;
+
+    // Pool settings
+    uint32_t _min_threads;
+    uint32_t _max_threads;
+    uint32_t _accept_queue;
+
     // Server socket to accept connections on
-    int _server_socket, _max_threads = 4;
+    int _server_socket;
 
     // Thread to run network on
     std::thread _thread;
 
+    // Threads serving connections
+    std::unique_ptr<Concurrency::Executor> _executor;
+
+    // Connections accepted and not closed yet, to be shut down on stop
     std::mutex _mutex;
-    std::map<int, std::thread> _workers;
-    std::condition_variable _join_threads;
-    void RUN(int client_socket);
+    std::unordered_set<int> _connections;
 };
 
 } // namespace MTblocking
@@ -1,6 +1,7 @@
 #include "Connection.h"
 
 #include <iostream>
+#include <stdexcept>
 #include <sys/socket.h>
 #include <sys/uio.h>
 
@@ -10,150 +11,230 @@ namespace MTnonblock {
 
 // See Connection.h
 void Connection::Start() {
-    _logger->info("Start st_nonblocking network connection on descriptor {} \n", _socket);
-    std::unique_lock<std::mutex> lock(mutex);
+    _logger->debug("Start st_nonblocking network connection on descriptor {} \n", _socket);
     _is_alive = true;
     // EPOLLIN - The associated file is available for read(2) operations.
     // EPOLLPRI - There is urgent data available for read(2) operations.
     // EPOLLRDHUP - Stream socket peer closed connection, or shut down writing half of connection.
     // EPOLLERR - Error condition happened on the associated file descriptor
-    _event.events = EPOLLIN | EPOLLPRI | EPOLLRDHUP; //| EPOLLERR;
+    // EPOLLET - Connection is served by the single worker, so edge triggered registration is enough
+    _event.events = EPOLLIN | EPOLLPRI | EPOLLRDHUP | EPOLLET; //| EPOLLERR;
     command_to_execute.reset();
     argument_for_command.resize(0);
     parser.Reset();
     arg_remains = 0;
 
     // Prepare for reading
-    _written_bytes = 0;
-    _read_bytes = 0;
-    _results.clear();
+    _reading_paused = false;
+    _has_more = false;
+    _eof = false;
+    _input.clear();
+    _output.clear();
     _event.data.ptr = this;
 }
 
 // See Connection.h
 void Connection::OnError() {
     _logger->error("Error in connection on descriptor {} \n", _socket);
-    std::unique_lock<std::mutex> lock(mutex);
     OnClose();
 }
 
 // See Connection.h
 void Connection::OnClose() {
     _logger->debug("Close connection of descriptor {} \n", _socket);
-    std::unique_lock<std::mutex> lock(mutex);
     _is_alive = false;
 }
 
 // See Connection.h
 void Connection::DoRead() {
     _logger->debug("Read from connection on descriptor {} \n", _socket);
-    std::unique_lock<std::mutex> lock(mutex);
     int client_socket = _socket;
-    command_to_execute = nullptr;
     try {
-        _bytes_for_read = 0;
-        while ((_bytes_for_read =
-                    read(client_socket, client_buffer + _read_bytes, sizeof(client_buffer) - _read_bytes)) > 0) {
-            //_logger->debug("Got {} bytes from socket", _read_bytes);
-            _read_bytes += _bytes_for_read;
-            // Single block of data readed from the socket could trigger inside actions a multiple times,
-            // for example:
-            // - read#0: [<command1 start>]
-            // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
-            while (_read_bytes > 0) {
-                _logger->debug("Process {} bytes", _read_bytes);
-                // There is no command yet
-                if (!command_to_execute) {
-                    std::size_t parsed = 0;
-                    if (parser.Parse(client_buffer, _read_bytes, parsed)) {
-                        // There is no command to be launched, continue to parse input stream
-                        // Here we are, current chunk finished some command, process it
-                        _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
-                        command_to_execute = parser.Build(arg_remains);
-                        if (arg_remains > 0) {
-                            arg_remains += 2;
-                        }
-                    }
-
-                    // Parsed might fails to consume any bytes from input stream. In real life that could happens,
-                    // for example, because we are working with UTF-16 chars and only 1 byte left in stream
-                    if (parsed == 0) {
-                        break;
-                    } else {
-                        std::memmove(client_buffer, client_buffer + parsed, _read_bytes - parsed);
-                        _read_bytes -= parsed;
-                    }
+        _commands_done = 0;
+        _bytes_read = 0;
+
+        // Input left since reading was paused or budget was spent goes first
+        Process();
+        while (_is_alive && !_reading_paused && !Exhausted()) {
+            // Socket data goes straight to the tail of input chain, so command of any size fits in
+            std::size_t space = 0;
+            char *tail = _input.prepare(space);
+            ssize_t readed_bytes = read(client_socket, tail, space);
+            if (readed_bytes == 0) {
+                _logger->debug("Connection on descriptor {} closed by client", client_socket);
+                _eof = true;
+                break;
+            } else if (readed_bytes < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    // EAGAIN - Resource temporarily unvailable
+                    _logger->debug("Client stop to write to connection on descriptor {}", client_socket);
+                    break;
                 }
+                throw std::runtime_error(std::string(strerror(errno)));
+            }
 
-                // There is command, but we still wait for argument to arrive...
-                if (command_to_execute && arg_remains > 0) {
-                    _logger->debug("Fill argument: {} bytes of {}", _read_bytes, arg_remains);
-                    // There is some parsed command, and now we are reading argument
-                    std::size_t to_read = std::min(arg_remains, std::size_t(_read_bytes));
-                    argument_for_command.append(client_buffer, to_read);
-                    std::memmove(client_buffer, client_buffer + to_read, _read_bytes - to_read);
-                    arg_remains -= to_read;
-                    _read_bytes -= to_read;
-                }
-
-                // Thre is command & argument - RUN!
-                if (command_to_execute && arg_remains == 0) {
-                    _logger->debug("Start command execution");
-
-                    std::string result;
-                    command_to_execute->Execute(*pStorage, argument_for_command, result);
-                    bool fuckingflag = _results.empty();
-                    // Send response
-                    result += "\r\n";
-                    _results.push_back(result);
-                    if (fuckingflag) {
-                        _event.events |= EPOLLOUT;
-                    };
-
-                    // Prepare for the next command
-                    command_to_execute.reset();
-                    argument_for_command.resize(0);
-                    parser.Reset();
-                }
-            } // while (readed_bytes)
+            _logger->debug("Got {} bytes from socket", readed_bytes);
+            _input.commit(readed_bytes);
+            _bytes_read += readed_bytes;
+            Process();
         }
-        // EAGAIN - Resource temporarily unvailable
-        _logger->debug("Client stop to write to connection on descriptor {}", client_socket);
-        if (errno == EAGAIN) {
-            throw std::runtime_error(std::string(strerror(errno)));
+
+        // Socket isn't drained yet or some commands are left in the input, event loop should come back
+        // once others get their turn
+        _has_more = _is_alive && !_reading_paused && Exhausted();
+
+        // Connection waits for the next request, give borrowed memory back until it arrives
+        if (!_has_more && _input.empty()) {
+            _input.clear();
+            if (!command_to_execute) {
+                std::string().swap(argument_for_command);
+            }
+            std::string().swap(result_of_command);
         }
     } catch (std::runtime_error &ex) {
         _logger->error("failed to read from connection on descriptor {}: {}", client_socket, ex.what());
+        if (_fifo) {
+            Resync(ex.what());
+        } else {
+            // Unparsed bytes stay in the input, there is no way to resync with the client
+            _is_alive = false;
+        }
+    }
+}
+
+// See Connection.h
+void Connection::Resync(const char *error) {
+    command_to_execute.reset();
+    argument_for_command.resize(0);
+    parser.Reset();
+    arg_remains = 0;
+
+    // Rest of the broken request is most likely in FIFO already
+    _input.clear();
+    char drain[4096];
+    while (read(_socket, drain, sizeof(drain)) > 0) {
+    }
+    _has_more = false;
+
+    _output.append("CLIENT_ERROR ", 13);
+    _output.append(error, strlen(error));
+    _output.append("\r\n", 2);
+}
+
+// See Connection.h
+void Connection::Process() {
+    // Single block of data readed from the socket could trigger inside actions a multiple times,
+    // for example:
+    // - read#0: [<command1 start>]
+    // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+    std::size_t size = 0;
+    const char *data;
+    while (_is_alive && !_reading_paused && !Exhausted() && (data = _input.peek(size)) != nullptr) {
+        _logger->debug("Process {} bytes", size);
+        // There is no command yet
+        if (!command_to_execute) {
+            std::size_t parsed = 0;
+            if (parser.Parse(data, size, parsed)) {
+                // There is no command to be launched, continue to parse input stream
+                // Here we are, current chunk finished some command, process it
+                _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                command_to_execute = parser.BuildInPlace(arg_remains);
+                arg_remains = parser.BlockSize();
+            }
+
+            // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+            // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+            if (parsed == 0) {
+                break;
+            }
+            _input.consume(parsed);
+            data += parsed;
+            size -= parsed;
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (command_to_execute && arg_remains > 0) {
+            _logger->debug("Fill argument: {} bytes of {}", size, arg_remains);
+            // There is some parsed command, and now we are reading argument
+            std::size_t to_read = std::min(arg_remains, size);
+            argument_for_command.append(data, to_read);
+            _input.consume(to_read);
+            arg_remains -= to_read;
+        }
+
+        // Thre is command & argument - RUN!
+        if (command_to_execute && arg_remains == 0) {
+            _logger->debug("Start command execution");
+
+            parser.StripBlock(argument_for_command);
+
+            result_of_command.clear();
+            command_to_execute->Execute(*pStorage, argument_for_command, result_of_command);
+            // Responses of the whole batch go out by a single write once it is processed, see Worker::Flush.
+            // EPOLLOUT is requested only if socket doesn't take them all
+            _output.append(result_of_command);
+            _output.append("\r\n", 2);
+
+            // Prepare for the next command
+            _commands_done++;
+            command_to_execute.reset();
+            argument_for_command.resize(0);
+            parser.Reset();
+
+            // Client doesn't read responses, stop to read its commands until it does
+            if (_output.size() > kOutputHardLimit) {
+                _logger->warn("Output of connection on descriptor {} exceeds {} bytes, disconnect", _socket,
+                              kOutputHardLimit);
+                _stats.overflows++;
+                _is_alive = false;
+            } else if (_output.size() > kOutputHighWatermark) {
+                _logger->debug("Pause reading from connection on descriptor {}", _socket);
+                _stats.paused++;
+                _reading_paused = true;
+                _event.events &= ~(EPOLLIN | EPOLLPRI);
+            }
+        }
     }
 }
 
 // See Connection.h
 void Connection::DoWrite() {
     _logger->debug("Writing in connection on descriptor {} \n", _socket);
-    std::unique_lock<std::mutex> lock(mutex);
-    assert(!_results.empty());
+    assert(!_output.empty());
     try {
-        std::size_t size = _results.size();
-        auto it = _results.begin();
-        struct iovec iov[size];
-        for (std::size_t i = 1; i < size; ++i, ++it) {
-            iov[i].iov_base = &(*it)[0]; // begin of string, which in vector;
-            iov[i].iov_len = (*it).size();
+        // Single writev flushes as many queued blocks as possible, partial write resumes from
+        // where it stopped on the next call
+        ssize_t written = 0;
+        if (_out_socket == -1) {
+            // Nobody reads responses
+            _output.clear();
+        } else {
+            // Single writev takes limited number of blocks, edge triggered epoll won't report socket
+            // that still has room for the rest
+            do {
+                written = _output.write(_out_socket);
+            } while (written > 0 && !_output.empty());
         }
-        iov[0].iov_base = (char *)iov[0].iov_base + _written_bytes;
-        iov[0].iov_len -= _written_bytes;
-
-        int written = writev(_socket, iov, size);
-        _written_bytes += written;
-        it = _results.begin();
-        while (it != _results.end() && _written_bytes >= it->size()) {
-            _written_bytes -= it->size();
-            ++it;
+        if (written == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Wait until socket gets writable
+                _event.events |= EPOLLOUT;
+                return;
+            }
+            throw std::runtime_error(std::string(strerror(errno)));
+        }
+
+        if (_reading_paused && _output.size() <= kOutputLowWatermark) {
+            _logger->debug("Resume reading from connection on descriptor {}", _socket);
+            _stats.resumed++;
+            _reading_paused = false;
+            _event.events |= EPOLLIN | EPOLLPRI;
         }
 
-        _results.erase(_results.begin(), it);
-        if (_results.empty()) {
-            _event.events |= EPOLLIN;
+        if (_output.empty()) {
+            _event.events = EPOLLIN | EPOLLPRI | EPOLLRDHUP | EPOLLET;
+        } else {
+            _event.events |= EPOLLOUT;
         }
     } catch (std::runtime_error &ex) {
         _logger->error("Failed to writing to connection on descriptor {}: {} \n", _socket, ex.what());
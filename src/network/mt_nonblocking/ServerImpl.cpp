@@ -1,25 +1,31 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 
 #include <arpa/inet.h>
-#include <netdb.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <signal.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 #include <spdlog/logger.h>
 
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
+#include <network/common/Peer.h>
+#include <network/common/Tuning.h>
 
 #include "Connection.h"
 #include "Utils.h"
@@ -29,14 +35,44 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
+namespace {
+
+// Address family of listening stream socket, -1 if socket is something else
+int ListeningFamily(int socket) {
+    int family = -1, type = -1, listening = 0;
+    socklen_t len = sizeof(int);
+    if (getsockopt(socket, SOL_SOCKET, SO_DOMAIN, &family, &len) == -1 ||
+        getsockopt(socket, SOL_SOCKET, SO_TYPE, &type, &len) == -1 ||
+        getsockopt(socket, SOL_SOCKET, SO_ACCEPTCONN, &listening, &len) == -1 || type != SOCK_STREAM ||
+        !listening) {
+        return -1;
+    }
+    return family;
+}
+
+// True if socket is one of SO_REUSEPORT group
+bool IsReuseport(int socket) {
+    int opts = 0;
+    socklen_t len = sizeof(int);
+    return getsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &opts, &len) == 0 && opts != 0;
+}
+
+} // namespace
+
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl, bool reuseport,
+                       bool pin_cpu, uint32_t idle_timeout, uint32_t read_timeout, uint32_t drain_timeout,
+                       const Budget &budget, const Listeners &listeners, uint32_t spin)
+    : Server(ps, pl), _reuseport(reuseport), _pin_cpu(pin_cpu), _idle_timeout(idle_timeout),
+      _read_timeout(read_timeout), _drain_timeout(drain_timeout), _budget(budget), _listeners(listeners), _spin(spin),
+      _server_socket(-1), _unix_socket(-1),
+      _released(false), _next_worker(0) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
 
 // See Server.h
-void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
+void ServerImpl::Start(const Options &options) {
     _logger = pLogging->select("network");
     _logger->info("Start mt_nonblocking network service");
 
@@ -47,84 +83,332 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
         throw std::runtime_error("Unable to mask SIGPIPE");
     }
 
+    _event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Sockets taken over from the previous process replace new ones, those left unused are closed. Their
+    // pending connections are lost, so run the same configuration as the previous process did
+    std::vector<int> tcp_sockets, unix_sockets;
+    for (int socket : _inherited) {
+        int family = ListeningFamily(socket);
+        if (family == AF_INET || family == AF_INET6) {
+            tcp_sockets.push_back(socket);
+        } else if (family == AF_UNIX) {
+            unix_sockets.push_back(socket);
+        } else {
+            _logger->warn("Inherited descriptor {} isn't a listening socket, close it", socket);
+            close(socket);
+        }
+    }
+    _inherited.clear();
+    if (!tcp_sockets.empty() && IsReuseport(tcp_sockets[0]) != _reuseport) {
+        for (int socket : tcp_sockets) {
+            close(socket);
+        }
+        for (int socket : unix_sockets) {
+            close(socket);
+        }
+        throw std::runtime_error("Inherited sockets are listened in other mode, check --reuseport");
+    }
+
+    std::size_t tcp_used = _reuseport ? std::min<std::size_t>(options.workers, tcp_sockets.size())
+                                      : std::min<std::size_t>(1, tcp_sockets.size());
+    for (std::size_t i = tcp_used; i < tcp_sockets.size(); i++) {
+        _logger->warn("Inherited socket {} isn't needed, close it", tcp_sockets[i]);
+        close(tcp_sockets[i]);
+    }
+    if (!unix_sockets.empty()) {
+        if (!_listeners.unix_socket.empty()) {
+            _unix_socket = unix_sockets[0];
+        }
+        for (std::size_t i = _unix_socket == -1 ? 0 : 1; i < unix_sockets.size(); i++) {
+            _logger->warn("Inherited unix socket {} isn't needed, close it", unix_sockets[i]);
+            close(unix_sockets[i]);
+        }
+    }
+
+    // Local endpoints, FIFO pair is served by the first worker
+    int rfifo = -1, wfifo = -1;
+    if (!_listeners.rfifo.empty()) {
+        rfifo = OpenFifo(_listeners.rfifo);
+        _logger->info("Read commands from FIFO {}", _listeners.rfifo);
+    }
+    if (!_listeners.wfifo.empty()) {
+        wfifo = OpenFifo(_listeners.wfifo);
+        _logger->info("Write responses to FIFO {}", _listeners.wfifo);
+    }
+    if (!_listeners.unix_socket.empty()) {
+        if (_unix_socket == -1) {
+            _unix_socket = ListenUnix(_listeners.unix_socket, options.backlog);
+        }
+        _logger->info("Accept connections on unix socket {}", _listeners.unix_socket);
+    }
+    if (_listeners.udp_port != 0) {
+        _logger->info("Serve UDP requests on port {}", _listeners.udp_port);
+    }
+
+    // Descriptors not handed to a worker yet, they are closed if a worker fails to start
+    std::size_t started = 0;
+    int epoll_fd = -1, server_socket = -1;
+    unsigned cpus = std::thread::hardware_concurrency();
+    try {
+        if (_reuseport) {
+            // Every worker gets own socket and epoll, kernel balances connections between sockets
+            _logger->info("Shared nothing mode, {} workers accept connections by themselves", options.workers);
+
+            _workers.reserve(options.workers);
+            for (uint32_t i = 0; i < options.workers; i++) {
+                server_socket = i < tcp_used ? tcp_sockets[i] : Listen(options, true);
+                epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+                if (epoll_fd == -1) {
+                    throw std::runtime_error("Failed to create epoll file descriptor: " +
+                                             std::string(strerror(errno)));
+                }
+
+                int cpu = (_pin_cpu && cpus > 0) ? int(i % cpus) : -1;
+                _workers.emplace_back(pStorage, pLogging, _idle_timeout, _read_timeout, _drain_timeout, _budget,
+                                      _spin);
+                if (i == 0 && rfifo != -1) {
+                    _workers.back().ServeFifo(rfifo, wfifo);
+                }
+                if (_listeners.udp_port != 0) {
+                    _workers.back().ServeUdp(ListenUdp(_listeners.udp_port));
+                }
+                _workers.back().Start(epoll_fd, server_socket, cpu);
+                started++;
+                epoll_fd = server_socket = -1;
+            }
+
+            // Unix socket has no SO_REUSEPORT group, the single acceptor hands its connections out
+            if (_unix_socket != -1) {
+                _acceptors.emplace_back(&ServerImpl::OnRun, this);
+            }
+            return;
+        }
+
+        _server_socket = tcp_used > 0 ? tcp_sockets[0] : Listen(options, false);
+
+        // Start IO workers, each has own epoll and acceptors distribute connections between them
+        _workers.reserve(options.workers);
+        for (uint32_t i = 0; i < options.workers; i++) {
+            epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+            if (epoll_fd == -1) {
+                throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+            }
+
+            int cpu = (_pin_cpu && cpus > 0) ? int(i % cpus) : -1;
+            _workers.emplace_back(pStorage, pLogging, _idle_timeout, _read_timeout, _drain_timeout, _budget, _spin);
+            if (i == 0 && rfifo != -1) {
+                _workers.back().ServeFifo(rfifo, wfifo);
+            }
+
+            // Every worker has own datagram socket, kernel spreads clients between them
+            if (_listeners.udp_port != 0) {
+                _workers.back().ServeUdp(ListenUdp(_listeners.udp_port));
+            }
+            _workers.back().Start(epoll_fd, -1, cpu);
+            started++;
+            epoll_fd = -1;
+        }
+
+        // Start acceptors
+        _acceptors.reserve(options.acceptors);
+        for (uint32_t i = 0; i < options.acceptors; i++) {
+            _acceptors.emplace_back(&ServerImpl::OnRun, this);
+        }
+    } catch (...) {
+        // Worker that failed to start closes only its own event and datagram descriptors, the rest are
+        // still ours. Inherited sockets after the failed one haven't been given to anybody either
+        _workers.erase(_workers.begin() + started, _workers.end());
+        if (epoll_fd != -1) {
+            close(epoll_fd);
+        }
+        if (server_socket != -1) {
+            close(server_socket);
+        }
+        for (std::size_t i = started + 1; _reuseport && i < tcp_used; i++) {
+            close(tcp_sockets[i]);
+        }
+        if (started == 0 && rfifo != -1) {
+            close(rfifo);
+            if (wfifo != -1) {
+                close(wfifo);
+            }
+        }
+
+        // Threads started so far run on the server's objects, they must be gone before it fails
+        Stop();
+        Join();
+        throw;
+    }
+}
+
+// See ServerImpl.h
+bool ServerImpl::Dispatch(int socket) {
+    // Scan starts from the next worker each time, so equally loaded ones get connections in turn
+    std::size_t n = _workers.size();
+    std::size_t start = _next_worker++ % n;
+    std::size_t best = start;
+    uint64_t best_load = std::numeric_limits<uint64_t>::max();
+    for (std::size_t i = 0; i < n; i++) {
+        std::size_t w = (start + i) % n;
+        uint64_t load = _workers[w].Load();
+        if (load < best_load) {
+            best = w;
+            best_load = load;
+        }
+    }
+
+    if (_workers[best].Register(socket)) {
+        return true;
+    }
+
+    // Worker's queue gets full only if the worker is stuck, any other one is better than nothing
+    for (std::size_t i = 0; i < n; i++) {
+        std::size_t w = (start + i) % n;
+        if (w != best && _workers[w].Register(socket)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// See ServerImpl.h
+int ServerImpl::Listen(const Options &options, bool reuseport) {
     // Create server socket
     struct sockaddr_in server_addr;
     std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+    server_addr.sin_family = AF_INET;           // IPv4
+    server_addr.sin_port = htons(options.port); // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY;   // Bind to any address
 
-    _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (_server_socket == -1) {
+    // Process exec'd to take over gets the socket by handover only
+    int server_socket = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (server_socket == -1) {
         throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
     }
 
     int opts = 1;
-    if (setsockopt(_server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
-        close(_server_socket);
+    if (setsockopt(server_socket, SOL_SOCKET, (SO_KEEPALIVE), &opts, sizeof(opts)) == -1) {
+        close(server_socket);
         throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
     }
 
-    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
-        close(_server_socket);
+    if (reuseport && setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &opts, sizeof(opts)) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(server_socket);
         throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
     }
 
-    make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
-        close(_server_socket);
+    make_socket_non_blocking(server_socket);
+    TuneListening(server_socket, options);
+
+    if (listen(server_socket, options.backlog) == -1) {
+        close(server_socket);
         throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
     }
+    return server_socket;
+}
 
-    // Start IO workers
-    _data_epoll_fd = epoll_create1(0);
-    if (_data_epoll_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+// See ServerImpl.h
+int ServerImpl::ListenUnix(const std::string &path, uint32_t backlog) {
+    struct sockaddr_un server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(server_addr.sun_path)) {
+        throw std::runtime_error("Unix socket path is too long: " + path);
     }
+    std::strcpy(server_addr.sun_path, path.c_str());
 
-    _event_fd = eventfd(0, EFD_NONBLOCK);
-    if (_event_fd == -1) {
-        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    // Socket left by the previous run makes bind() fail, but anything else at that path isn't ours
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(path.c_str());
     }
 
-    struct epoll_event event;
-    event.events = EPOLLIN;
-    event.data.ptr = nullptr;
-    if (epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
-        throw std::runtime_error("Failed to add eventfd descriptor to epoll");
+    int server_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server_socket == -1) {
+        throw std::runtime_error("Failed to open unix socket: " + std::string(strerror(errno)));
     }
 
-    _workers.reserve(n_workers);
-    for (int i = 0; i < n_workers; i++) {
-        _workers.emplace_back(pStorage, pLogging);
-        _workers.back().Start(_data_epoll_fd);
+    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Unix socket bind() failed: " + std::string(strerror(errno)));
     }
 
-    // Start acceptors
-    _acceptors.reserve(n_acceptors);
-    for (int i = 0; i < n_acceptors; i++) {
-        _acceptors.emplace_back(&ServerImpl::OnRun, this);
+    if (listen(server_socket, backlog) == -1) {
+        close(server_socket);
+        unlink(path.c_str());
+        throw std::runtime_error("Unix socket listen() failed: " + std::string(strerror(errno)));
     }
+    return server_socket;
+}
+
+// See ServerImpl.h
+int ServerImpl::OpenFifo(const std::string &path) {
+    if (mkfifo(path.c_str(), 0666) == -1 && errno != EEXIST) {
+        throw std::runtime_error("Failed to create FIFO " + path + ": " + std::string(strerror(errno)));
+    }
+
+    // Server holds both ends, so open doesn't wait for a peer, and clients closing their ends
+    // bring neither EOF nor EPIPE
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open FIFO " + path + ": " + std::string(strerror(errno)));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISFIFO(st.st_mode)) {
+        close(fd);
+        throw std::runtime_error(path + " is not a FIFO");
+    }
+    return fd;
+}
+
+// See ServerImpl.h
+int ServerImpl::ListenUdp(uint16_t port) {
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+
+    int server_socket = socket(PF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (server_socket == -1) {
+        throw std::runtime_error("Failed to open datagram socket: " + std::string(strerror(errno)));
+    }
+
+    int opts = 1;
+    if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEPORT, &opts, sizeof(opts)) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Datagram socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(server_socket);
+        throw std::runtime_error("Datagram socket bind() failed: " + std::string(strerror(errno)));
+    }
+    return server_socket;
 }
 
 // See Server.h
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
-    // Said workers to stop
-    for (auto &w : _workers) {
-        w.Stop();
-    }
-
-    // Wakeup threads that are sleep on epoll_wait
+    // Acceptors go first, sockets they hand over to stopped workers are closed unserved
     if (eventfd_write(_event_fd, 1)) {
-        throw std::runtime_error("Failed to wakeup workers");
+        throw std::runtime_error("Failed to wakeup acceptors");
     }
-    for(auto &it: _connections)
-    {
-        close(it->_socket);
-        delete it;
+
+    // Said workers to stop, they drain their connections and exit
+    for (auto &w : _workers) {
+        w.Stop();
     }
-    //close(_server_socket);
 }
 
 // See Server.h
@@ -133,24 +417,92 @@ void ServerImpl::Join() {
         t.join();
     }
 
+    // Socket is shared by all acceptors, so it is closed once nobody accepts on it anymore. Workers may
+    // drain for a while, new connections shouldn't wait for that in the backlog
+    if (_server_socket != -1) {
+        close(_server_socket);
+        _server_socket = -1;
+    }
+
     for (auto &w : _workers) {
         w.Join();
     }
+    _acceptors.clear();
+    _workers.clear();
+    close(_event_fd);
+
+    if (_unix_socket != -1) {
+        close(_unix_socket);
+        if (!_released) {
+            unlink(_listeners.unix_socket.c_str());
+        }
+        _unix_socket = -1;
+    }
 }
 
+// See Server.h
+void ServerImpl::Stats(std::vector<std::pair<std::string, std::size_t>> &stats) const {
+    std::size_t paused = 0, resumed = 0, overflows = 0, udp_dropped = 0;
+    for (auto &w : _workers) {
+        paused += w.Stats().paused.load();
+        resumed += w.Stats().resumed.load();
+        overflows += w.Stats().overflows.load();
+        udp_dropped += w.UdpDropped();
+    }
+    stats.emplace_back("output_paused", paused);
+    stats.emplace_back("output_resumed", resumed);
+    stats.emplace_back("output_overflows", overflows);
+    if (_listeners.udp_port != 0) {
+        stats.emplace_back("udp_dropped", udp_dropped);
+    }
+}
+
+// See Server.h
+bool ServerImpl::Inherit(const std::vector<int> &sockets) {
+    _inherited = sockets;
+    return true;
+}
+
+// See Server.h
+std::vector<int> ServerImpl::Listening() {
+    std::vector<int> sockets;
+    if (_server_socket != -1) {
+        sockets.push_back(_server_socket);
+    }
+    for (auto &w : _workers) {
+        if (w.ServerSocket() != -1) {
+            sockets.push_back(w.ServerSocket());
+        }
+    }
+    if (_unix_socket != -1) {
+        sockets.push_back(_unix_socket);
+    }
+    return sockets;
+}
+
+// See Server.h
+void ServerImpl::Release() { _released = true; }
+
 // See ServerImpl.h
 void ServerImpl::OnRun() {
     _logger->info("Start acceptor");
-    int acceptor_epoll = epoll_create1(0);
+    int acceptor_epoll = epoll_create1(EPOLL_CLOEXEC);
     if (acceptor_epoll == -1) {
         throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
     }
 
-    struct epoll_event event;
-    event.events = EPOLLIN | EPOLLEXCLUSIVE;
-    event.data.fd = _server_socket;
-    if (epoll_ctl(acceptor_epoll, EPOLL_CTL_ADD, _server_socket, &event)) {
-        throw std::runtime_error("Failed to add file descriptor to epoll");
+    // There is no TCP server socket for acceptor in shared nothing mode
+    for (int server_socket : {_server_socket, _unix_socket}) {
+        if (server_socket == -1) {
+            continue;
+        }
+
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.fd = server_socket;
+        if (epoll_ctl(acceptor_epoll, EPOLL_CTL_ADD, server_socket, &event)) {
+            throw std::runtime_error("Failed to add file descriptor to epoll");
+        }
     }
 
     struct epoll_event event2;
@@ -174,56 +526,38 @@ void ServerImpl::OnRun() {
                 continue;
             }
 
-            for (;;) {
-                struct sockaddr in_addr;
-                socklen_t in_len;
-
-                // No need to make these sockets non blocking since accept4() takes care of it.
-                in_len = sizeof in_addr;
-                int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
-                if (infd == -1) {
-                    if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
-                        break; // We have processed all incoming connections.
-                    } else {
-                        _logger->error("Failed to accept socket");
-                        break;
-                    }
-                }
+            OnNewConnection(current_event.data.fd);
+        }
+    }
+    close(acceptor_epoll);
+    _logger->warn("Acceptor stopped");
+}
 
-                // Print host and service info.
-                char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-                int retval = getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf,
-                                         NI_NUMERICHOST | NI_NUMERICSERV);
-                if (retval == 0) {
-                    _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
-                }
+// See ServerImpl.h
+void ServerImpl::OnNewConnection(int server_socket) {
+    for (;;) {
+        // No need to make these sockets non blocking since accept4() takes care of it. Peer address is
+        // not copied out, it is asked for only if gets logged
+        int infd = accept4(server_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (infd == -1) {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                break; // We have processed all incoming connections.
+            } else {
+                _logger->error("Failed to accept socket");
+                break;
+            }
+        }
 
-                // Register the new FD to be monitored by epoll.
-                Connection *pc = new Connection(infd, _logger, pStorage);
-                if (pc == nullptr) {
-                    throw std::runtime_error("Failed to allocate connection");
-                }
+        if (_logger->should_log(spdlog::level::debug)) {
+            _logger->debug("Accepted connection on descriptor {} from {}", infd, PeerName(infd));
+        }
 
-                // Register connection in worker's epoll
-                pc->Start();
-                if (pc->isAlive()) {
-                    pc->_event.events |= EPOLLET;
-                    pc->_event.events |= EPOLLONESHOT;
-                    int epoll_ctl_retval;
-                    if ((epoll_ctl_retval = epoll_ctl(_data_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event))) {
-                        _logger->debug("epoll_ctl failed during connection register in workers'epoll: error {}", epoll_ctl_retval);
-                        pc->OnError();
-                        delete pc;
-                    }else{
-                        std::lock_guard<std::mutex> lock(_mutex);
-                        _connections.insert(pc);
-                    }
-                }
-            }
+        // Pin connection to the least loaded worker, it stays there till the end
+        if (!Dispatch(infd)) {
+            _logger->error("All workers are overloaded, drop connection on descriptor {}", infd);
+            close(infd);
         }
     }
-    close(_server_socket);
-    _logger->warn("Acceptor stopped");
 }
 
 } // namespace MTnonblock
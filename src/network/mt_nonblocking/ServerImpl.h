@@ -1,12 +1,12 @@
 #ifndef AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 #define AFINA_NETWORK_MT_NONBLOCKING_SERVER_H
 
+#include <atomic>
 #include <thread>
 #include <vector>
-#include <unordered_set>
-#include <mutex>
 #include <afina/network/Server.h>
 #include "Connection.h"
+#include <network/common/Listeners.h>
 
 namespace spdlog {
 class logger;
@@ -21,15 +21,30 @@ class Worker;
 
 /**
  * # Network resource manager implementation
- * Epoll based server
+ * Epoll based server. By default acceptor threads hand every connection over to the least loaded worker,
+ * each worker has own epoll instance. In shared nothing mode there are no acceptors: each worker has own SO_REUSEPORT server socket
+ * and own epoll, so connection is served by the worker accepted it for the whole its life
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    /**
+     * @param reuseport enables shared nothing mode
+     * @param pin_cpu pins each worker to its own CPU
+     * @param idle_timeout milliseconds connection could wait for a new request, 0 for no limit
+     * @param read_timeout milliseconds started request must be received in, 0 for no limit
+     * @param drain_timeout milliseconds connections have to send queued responses on Stop
+     * @param budget work connection could do per wakeup
+     * @param listeners local endpoints served in addition to TCP port
+     * @param spin microseconds workers poll for events before sleeping, 0 to sleep right away
+     */
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl, bool reuseport = false,
+               bool pin_cpu = false, uint32_t idle_timeout = 0, uint32_t read_timeout = 0,
+               uint32_t drain_timeout = 0, const Budget &budget = Budget(), const Listeners &listeners = Listeners(),
+               uint32_t spin = 0);
     ~ServerImpl();
 
     // See Server.h
-    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+    void Start(const Options &options) override;
 
     // See Server.h
     void Stop() override;
@@ -37,9 +52,51 @@ public:
     // See Server.h
     void Join() override;
 
+    // See Server.h
+    void Stats(std::vector<std::pair<std::string, std::size_t>> &stats) const override;
+
+    // See Server.h
+    bool Inherit(const std::vector<int> &sockets) override;
+
+    // See Server.h
+    std::vector<int> Listening() override;
+
+    // See Server.h
+    void Release() override;
+
 protected:
     void OnRun();
-    void OnNewConnection();
+
+    /**
+     * Accepts all pending connections on the given server socket and dispatches them to workers
+     */
+    void OnNewConnection(int server_socket);
+
+    /**
+     * Hands accepted socket over to the least loaded worker, see Worker::Load(). Returns false if no
+     * worker could take it
+     */
+    bool Dispatch(int socket);
+
+    /**
+     * Creates non blocking server socket listening on the port of options, tuned as they say
+     */
+    int Listen(const Options &options, bool reuseport);
+
+    /**
+     * Creates non blocking Unix domain stream socket listening on the given path
+     */
+    int ListenUnix(const std::string &path, uint32_t backlog);
+
+    /**
+     * Opens FIFO for both reading and writing, creates it if missing
+     */
+    int OpenFifo(const std::string &path);
+
+    /**
+     * Creates non blocking datagram socket bound to the given port, one of SO_REUSEPORT group
+     */
+    int ListenUdp(uint16_t port);
 
 private:
     // logger to use
@@ -50,25 +107,50 @@ private:
     // Read-only
     uint16_t listen_port;
 
+    // Shared nothing mode settings
+    bool _reuseport;
+    bool _pin_cpu;
+
+    // Connection timeouts in milliseconds, see Worker.h
+    uint32_t _idle_timeout;
+    uint32_t _read_timeout;
+
+    // Drain deadline in milliseconds, see Worker.h
+    uint32_t _drain_timeout;
+
+    // Work connection could do per wakeup, see Budget.h
+    Budget _budget;
+
+    // Local endpoints, see Listeners.h
+    Listeners _listeners;
+
+    // Microseconds workers spin before sleeping, see Worker.h
+    uint32_t _spin;
+
     // Socket to accept new connection on, shared between acceptors
     int _server_socket;
 
+    // Unix domain socket to accept new connection on, shared between acceptors as well, -1 if none
+    int _unix_socket;
+
+    // Listening sockets taken over from the previous process, used by Start instead of new ones
+    std::vector<int> _inherited;
+
+    // Listening sockets are passed to the next process, whatever they are bound to is its now
+    std::atomic<bool> _released;
+
     // Threads that accepts new connections, each has private epoll instance
     // but share global server socket
     std::vector<std::thread> _acceptors;
 
-    // EPOLL instance shared between workers
-    int _data_epoll_fd;
-
-    // Curstom event "device" used to wakeup workers
+    // Curstom event "device" used to wakeup acceptors
     int _event_fd;
 
     // threads serving read/write requests
     std::vector<Worker> _workers;
 
-    std::unordered_set<Connection*> _connections;
-
-    std::mutex _mutex;
+    // Worker to start the least loaded one search from
+    std::atomic<uint32_t> _next_worker;
 };
 
 } // namespace MTnonblock
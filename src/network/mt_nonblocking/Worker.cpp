@@ -1,17 +1,26 @@
 #include "Worker.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <cstring>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
 
-#include <netdb.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <spdlog/logger.h>
 
 #include <afina/logging/Service.h>
+#include <network/common/Peer.h>
 
 #include "Connection.h"
 #include "Utils.h"
@@ -20,49 +29,223 @@ namespace Afina {
 namespace Network {
 namespace MTnonblock {
 
-// See Worker.h
-Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
-    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1) {
-    // TODO: implementation here
+namespace {
+
+// Monotonic time in milliseconds
+uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Monotonic time in microseconds
+uint64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
 }
 
+// Sockets could be queued for worker between its wakeups
+const std::size_t kIncomingCapacity = 1024;
+
+// Period event rate of worker is measured over, milliseconds
+const uint64_t kLoadWindow = 100;
+
+// Longest gap between events taken into the average, microseconds. Worker idle for long gets back
+// to spinning after a few dense events
+const uint64_t kMaxEventGap = 1000000;
+
+// recvmmsg batches served per wakeup, socket is level triggered so the rest waits for the next one
+const std::size_t kUdpBatches = 4;
+
+} // namespace
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+               uint32_t idle_timeout, uint32_t read_timeout, uint32_t drain_timeout, const Budget &budget,
+               uint32_t spin)
+    : _pStorage(ps), _pLogging(pl), isRunning(false), _epoll_fd(-1), _server_socket(-1), _wakeup_fd(-1), _rfifo(-1),
+      _wfifo(-1), _udp_socket(-1), _cpu(-1), _idle_timeout(idle_timeout), _read_timeout(read_timeout),
+      _drain_timeout(drain_timeout), _budget(budget), _spin(spin), _incoming(new MpscQueue<int>(kIncomingCapacity)),
+      _wakeup_pending(false), _load_connections(0), _load_events(0), _load_time(0), _last_event(0),
+      _event_gap(kMaxEventGap), _window_events(0), _window_start(0), _udp_dropped(0) {}
+
 // See Worker.h
 Worker::~Worker() {
-    // TODO: implementation here
+    // Joined worker has released everything already, these are left by one which has never run
+    if (_wakeup_fd != -1) {
+        close(_wakeup_fd);
+    }
+    if (_udp_socket != -1 && !_udp) {
+        close(_udp_socket);
+    }
 }
 
 // See Worker.h
-Worker::Worker(Worker &&other) { *this = std::move(other); }
+Worker::Worker(Worker &&other)
+    : isRunning(false), _epoll_fd(-1), _server_socket(-1), _wakeup_fd(-1), _rfifo(-1), _wfifo(-1), _udp_socket(-1),
+      _wakeup_pending(false), _load_connections(0), _load_events(0), _load_time(0), _udp_dropped(0) {
+    *this = std::move(other);
+}
 
 // See Worker.h
 Worker &Worker::operator=(Worker &&other) {
     _pStorage = std::move(other._pStorage);
     _pLogging = std::move(other._pLogging);
     _logger = std::move(other._logger);
+    isRunning.store(other.isRunning.load());
     _thread = std::move(other._thread);
     _epoll_fd = other._epoll_fd;
+    _server_socket = other._server_socket;
+    _wakeup_fd = other._wakeup_fd;
+    _rfifo = other._rfifo;
+    _wfifo = other._wfifo;
+    _udp_socket = other._udp_socket;
+    _cpu = other._cpu;
+    _idle_timeout = other._idle_timeout;
+    _read_timeout = other._read_timeout;
+    _drain_timeout = other._drain_timeout;
+    _budget = other._budget;
+    _spin = other._spin;
+    _last_event = other._last_event;
+    _event_gap = other._event_gap;
+    _incoming = std::move(other._incoming);
+    _wakeup_pending.store(other._wakeup_pending.load());
+    _load_connections.store(other._load_connections.load());
+    _load_events.store(other._load_events.load());
+    _load_time.store(other._load_time.load());
+    _window_events = other._window_events;
+    _window_start = other._window_start;
+    _connections = std::move(other._connections);
+    _udp = std::move(other._udp);
+    _timers = std::move(other._timers);
+    _udp_dropped.store(other._udp_dropped.load());
+    // Pools and counters stay in place, workers are moved before start only when they are empty
 
     other._epoll_fd = -1;
+    other._server_socket = -1;
+    other._wakeup_fd = -1;
+    other._rfifo = -1;
+    other._wfifo = -1;
+    other._udp_socket = -1;
     return *this;
 }
 
 // See Worker.h
-void Worker::Start(int epoll_fd) {
+void Worker::Start(int epoll_fd, int server_socket, int cpu) {
     if (isRunning.exchange(true) == false) {
         assert(_epoll_fd == -1);
         _epoll_fd = epoll_fd;
+        _server_socket = server_socket;
+        _cpu = cpu;
         _logger = _pLogging->select("network.worker");
+        _timers.reset(new TimerWheel(Now()));
+        _window_start = Now();
+        _load_time = _window_start;
+
+        _wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_wakeup_fd == -1) {
+            throw std::runtime_error("Failed to create worker event descriptor: " + std::string(strerror(errno)));
+        }
+
+        struct epoll_event wakeup_event;
+        wakeup_event.events = EPOLLIN;
+        wakeup_event.data.ptr = &_wakeup_fd;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wakeup_fd, &wakeup_event)) {
+            throw std::runtime_error("Failed to add worker event descriptor to epoll");
+        }
+
+        if (_server_socket != -1) {
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.ptr = &_server_socket;
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _server_socket, &event)) {
+                throw std::runtime_error("Failed to add server socket to epoll");
+            }
+        }
+
+        if (_udp_socket != -1) {
+            _udp.reset(new UdpEndpoint(_udp_socket, _logger, _pStorage));
+
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.ptr = _udp.get();
+            if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _udp_socket, &event)) {
+                throw std::runtime_error("Failed to add datagram socket to epoll");
+            }
+        }
+
         _thread = std::thread(&Worker::OnRun, this);
+        if (_cpu >= 0) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(_cpu, &cpuset);
+            if (pthread_setaffinity_np(_thread.native_handle(), sizeof(cpuset), &cpuset) != 0) {
+                _logger->error("Failed to pin worker to cpu {}", _cpu);
+            }
+        }
+    }
+}
+
+// See Worker.h
+void Worker::ServeFifo(int rfifo, int wfifo) {
+    assert(!isRunning);
+    _rfifo = rfifo;
+    _wfifo = wfifo;
+}
+
+// See Worker.h
+void Worker::ServeUdp(int socket) {
+    assert(!isRunning);
+    _udp_socket = socket;
+}
+
+// See Worker.h
+bool Worker::Register(int socket) {
+    if (!_incoming->push(socket)) {
+        return false;
+    }
+
+    // Worker drains whole queue at once, so wake it up only if it isn't going to do that already
+    if (!_wakeup_pending.exchange(true) && eventfd_write(_wakeup_fd, 1)) {
+        _logger->error("Failed to wakeup worker: {}", strerror(errno));
+    }
+    return true;
+}
+
+// See Worker.h
+uint64_t Worker::Load() const {
+    // Rate isn't updated while worker sleeps, so halve it for every window passed since then
+    uint64_t events = _load_events.load(std::memory_order_relaxed);
+    uint64_t age = (Now() - _load_time.load(std::memory_order_relaxed)) / kLoadWindow;
+    if (age > 1) {
+        events = age < 64 ? events >> (age - 1) : 0;
     }
+    return _load_connections.load(std::memory_order_relaxed) + _incoming->size() + events;
 }
 
 // See Worker.h
-void Worker::Stop() { isRunning = false; }
+void Worker::Stop() {
+    isRunning = false;
+
+    // Worker could sleep with no timers at all
+    if (eventfd_write(_wakeup_fd, 1)) {
+        _logger->error("Failed to wakeup worker: {}", strerror(errno));
+    }
+}
 
 // See Worker.h
 void Worker::Join() {
     assert(_thread.joinable());
     _thread.join();
+
+    // Acceptors could hand sockets over until they stop, there is nobody to serve them now
+    int socket;
+    while (_incoming->pop(socket)) {
+        close(socket);
+    }
+    close(_wakeup_fd);
+    _wakeup_fd = -1;
 }
 
 // See Worker.h
@@ -70,73 +253,404 @@ void Worker::OnRun() {
     assert(_epoll_fd >= 0);
     _logger->trace("OnRun");
 
-    // Process connection events
-    //
-    // Do not forget to use EPOLLEXCLUSIVE flag when register socket
-    // for events to avoid thundering herd type behavior.
-    int timeout = -1;
+    if (_rfifo != -1) {
+        AttachFifo();
+    }
+
+    // Process connection events, sleep no longer than the nearest connection timer and don't sleep
+    // at all while some connections are ready
     std::array<struct epoll_event, 64> mod_list;
     while (isRunning) {
-        int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), timeout);
+        int timeout = _ready.empty() ? _timers->timeout(Now()) : 0;
+        int nmod = Poll(&mod_list[0], mod_list.size(), timeout);
         _logger->debug("Worker wokeup: {} events", nmod);
+        uint64_t now = Now();
+        _serving.swap(_ready);
 
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
 
-            // nullptr is used by server for event_fd "interface", if we got here then server
-            // signals us to wakeup to process some state change, ignore it in INNER loop, react
-            // on changes in OUTHER loop
-            if (current_event.data.ptr == nullptr) {
+            // Own server socket has pending connections
+            if (current_event.data.ptr == &_server_socket) {
+                OnAccept(now);
+                continue;
+            }
+
+            // Some other thread has handed connections over
+            if (current_event.data.ptr == &_wakeup_fd) {
+                OnRegister(now);
+                continue;
+            }
+
+            // Datagrams arrived
+            if (current_event.data.ptr == _udp.get()) {
+                _window_events += _udp->Serve(kUdpBatches);
+                _udp_dropped.store(_udp->dropped(), std::memory_order_relaxed);
                 continue;
             }
 
             // Some connection gets new data
             Connection *pconn = static_cast<Connection *>(current_event.data.ptr);
-            if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
-                _logger->debug("Got EPOLLERR or EPOLLHUP, value of returned events: {}", current_event.events);
-                pconn->DoRead();
-                pconn->DoWrite();
-                pconn->OnError();
-            } else if (current_event.events & EPOLLRDHUP) {
-                _logger->debug("Got EPOLLRDHUP, value of returned events: {}", current_event.events);
-                pconn->DoRead();
-                pconn->DoWrite();
+            uint32_t events = current_event.events;
+            if (pconn->_ready_events != 0) {
+                // Connection is going to be read from the ready list anyway
+                pconn->_ready_events |= events & EPOLLRDHUP;
+                events &= ~(EPOLLIN | EPOLLRDHUP);
+            }
+            OnEvent(pconn, events, now);
+        }
+
+        // Connections that spent their budget on the previous iteration get their next turn after everyone
+        // else got theirs
+        for (Connection *pconn : _serving) {
+            if (pconn != nullptr) {
+                uint32_t events = pconn->_ready_events;
+                pconn->_ready_events = 0;
+                OnEvent(pconn, events, now);
+            }
+        }
+        _serving.clear();
+
+        _timers->advance(now, [this](TimerWheel::Timer *timer) {
+            Connection *pconn = static_cast<Connection *>(timer->data);
+            _logger->debug("Connection on descriptor {} timed out", pconn->_socket);
+            Close(pconn);
+        });
+
+        // Publish event rate, smoothed so single burst doesn't scare acceptors away for long
+        if (now - _window_start >= kLoadWindow) {
+            uint64_t events = _window_events * kLoadWindow / (now - _window_start);
+            _load_events.store((_load_events.load(std::memory_order_relaxed) + events) / 2,
+                               std::memory_order_relaxed);
+            _load_time.store(now, std::memory_order_relaxed);
+            _window_events = 0;
+            _window_start = now;
+        }
+    }
+
+    // Nobody else knows about our resources
+    Drain();
+
+    if (_server_socket != -1) {
+        close(_server_socket);
+    }
+    close(_epoll_fd);
+    _logger->warn("Worker stopped");
+}
+
+// See Worker.h
+int Worker::Poll(struct epoll_event *events, int size, int timeout) {
+    int nmod = 0;
+    if (timeout != 0 && _spin > 0 && _event_gap < _spin) {
+        uint64_t start = NowUs();
+        do {
+            nmod = epoll_wait(_epoll_fd, events, size, 0);
+        } while (nmod == 0 && NowUs() - start < _spin);
+    }
+    if (nmod == 0) {
+        nmod = epoll_wait(_epoll_fd, events, size, timeout);
+    }
+
+    // Ready list is served without waiting, it doesn't tell anything about event rate
+    if (nmod > 0 && timeout != 0) {
+        uint64_t now = NowUs();
+        uint64_t gap = std::min(now - _last_event, kMaxEventGap);
+        _event_gap = (_event_gap * 3 + gap) / 4;
+        _last_event = now;
+    }
+    return nmod;
+}
+
+// See Worker.h
+void Worker::OnAccept(uint64_t now) {
+    for (;;) {
+        // No need to make these sockets non blocking since accept4() takes care of it. Peer address is
+        // not copied out, it is asked for only if gets logged
+        int infd = accept4(_server_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (infd == -1) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                _logger->error("Failed to accept socket");
+            }
+            break;
+        }
+
+        if (_logger->should_log(spdlog::level::debug)) {
+            _logger->debug("Accepted connection on descriptor {} from {}", infd, PeerName(infd));
+        }
+
+        // Connection lives in this worker only, register it in own epoll
+        Attach(infd, now);
+    }
+}
+
+// See Worker.h
+void Worker::OnRegister(uint64_t now) {
+    // Sockets registered since flag is dropped signal worker again
+    _wakeup_pending.exchange(false);
+    eventfd_t value;
+    eventfd_read(_wakeup_fd, &value);
+
+    int socket;
+    while (_incoming->pop(socket)) {
+        if (isRunning) {
+            Attach(socket, now);
+        } else {
+            close(socket);
+        }
+    }
+}
+
+// See Worker.h
+void Worker::Attach(int socket, uint64_t now) {
+    Connection *pc = _connection_pool.make(socket, _logger, _pStorage, _chunk_pool, _stats, _budget);
+    pc->Start();
+
+    int epoll_ctl_retval;
+    if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, pc->_socket, &pc->_event))) {
+        _logger->debug("epoll_ctl failed during connection register in worker epoll: error {}", epoll_ctl_retval);
+        pc->OnError();
+        close(socket);
+        _connection_pool.destroy(pc);
+        return;
+    }
+
+    _connections.insert(pc);
+    _load_connections.store(_connections.size(), std::memory_order_relaxed);
+    pc->_timer.data = pc;
+    Touch(pc, now);
+}
+
+// See Worker.h
+void Worker::AttachFifo() {
+    Connection *pc = _connection_pool.make(_rfifo, _logger, _pStorage, _chunk_pool, _stats, _budget);
+    pc->Start();
+    pc->_out_socket = _wfifo;
+    pc->_fifo = true;
+
+    // Output FIFO is watched only to resume writing once it has room again, events of both FIFOs are
+    // handled the same way
+    struct epoll_event out_event;
+    out_event.events = EPOLLOUT | EPOLLET;
+    out_event.data.ptr = pc;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _rfifo, &pc->_event) ||
+        (_wfifo != -1 && epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wfifo, &out_event))) {
+        _logger->error("Failed to add FIFO to epoll: {}", strerror(errno));
+        close(_rfifo);
+        if (_wfifo != -1) {
+            close(_wfifo);
+        }
+        _connection_pool.destroy(pc);
+        return;
+    }
+
+    // No timers: FIFO connection lives as long as worker does
+    _connections.insert(pc);
+    _load_connections.store(_connections.size(), std::memory_order_relaxed);
+    pc->_timer.data = pc;
+    _logger->info("Serve FIFO on descriptors {} and {}", _rfifo, _wfifo);
+}
+
+// See Worker.h
+void Worker::Touch(Connection *pc, uint64_t now) {
+    if (pc->_fifo) {
+        return;
+    }
+
+    bool in_request = pc->InRequest();
+    if (in_request && _read_timeout > 0) {
+        // Deadline is set once request starts, further reads don't move it
+        if (!pc->_in_request) {
+            _timers->schedule(&pc->_timer, now + _read_timeout);
+        }
+    } else if (_idle_timeout > 0) {
+        _timers->schedule(&pc->_timer, now + _idle_timeout);
+    } else {
+        _timers->cancel(&pc->_timer);
+    }
+    pc->_in_request = in_request;
+}
+
+// See Worker.h
+void Worker::OnEvent(Connection *pconn, uint32_t events, uint64_t now) {
+    _window_events++;
+    auto old_mask = pconn->_event.events;
+    if ((events & EPOLLERR) || (events & EPOLLHUP)) {
+        _logger->debug("Got EPOLLERR or EPOLLHUP, value of returned events: {}", events);
+        pconn->OnError();
+    } else {
+        // Depends on what connection wants... Client that has shut down its sending side still waits
+        // for responses, so EPOLLRDHUP is served as the last portion of input
+        if (events & (EPOLLIN | EPOLLRDHUP)) {
+            _logger->trace("Got EPOLLIN or EPOLLRDHUP");
+            pconn->DoRead();
+        }
+
+        // Socket is most likely writable, try to send responses right away: if it succeeds
+        // then interest doesn't change and there is no need to wait for EPOLLOUT
+        Flush(pconn);
+
+        // Connection is closed once commands over the budget are served and all responses are sent
+        if (pconn->isAlive() && pconn->_eof) {
+            if (pconn->_output.empty() && !pconn->_has_more) {
                 pconn->OnClose();
             } else {
-                // Depends on what connection wants...
-                if (current_event.events & EPOLLIN) {
-                    _logger->trace("Got EPOLLIN");
-                    pconn->DoRead();
-                }
-                if (current_event.events & EPOLLOUT) {
-                    _logger->trace("Got EPOLLOUT");
-                    pconn->DoWrite();
-                }
+                pconn->_event.events = pconn->_output.empty() ? EPOLLET : EPOLLOUT | EPOLLET;
             }
+        }
+    }
 
-            // Rearm connection
-            if (pconn->isAlive()) {
-                pconn->_event.events |= EPOLLONESHOT;
-                int epoll_ctl_retval;
-                if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
-                    _logger->debug("epoll_ctl failed during connection rearm: error {}", epoll_ctl_retval);
-                    pconn->OnError();
-                    close(pconn->_socket);
-                    delete pconn;
-                }
-            }
-            // Or delete closed one
-            else {
-                if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pconn->_socket, &pconn->_event)) {
-                    std::cerr << "Failed to delete connection!" << std::endl;
-                }
-                close(pconn->_socket);
-                delete pconn;
+    // Delete closed connection or update its registration if interest has changed
+    if (!pconn->isAlive()) {
+        Close(pconn);
+        return;
+    } else if (pconn->_event.events != old_mask) {
+        int epoll_ctl_retval;
+        if ((epoll_ctl_retval = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pconn->_socket, &pconn->_event))) {
+            _logger->debug("epoll_ctl failed during connection update: error {}", epoll_ctl_retval);
+            pconn->OnError();
+            Close(pconn);
+            return;
+        }
+    }
+
+    // Edge triggered epoll won't report data left since budget was spent, so queue connection to be
+    // served without it
+    if (pconn->_has_more) {
+        if (pconn->_ready_events == 0) {
+            _ready.push_back(pconn);
+        }
+        pconn->_ready_events |= EPOLLIN | (events & EPOLLRDHUP);
+    }
+    Touch(pconn, now);
+}
+
+// See Worker.h
+void Worker::Flush(Connection *pc) {
+    while (pc->isAlive() && !pc->_output.empty()) {
+        _logger->trace("Write responses");
+        bool paused = pc->_reading_paused;
+        pc->DoWrite();
+        if (!paused || pc->_reading_paused) {
+            break;
+        }
+
+        // Reading has been resumed, but edge triggered epoll won't report data that arrived while
+        // it was paused, so serve it right away
+        pc->DoRead();
+    }
+}
+
+// See Worker.h
+void Worker::Close(Connection *pc) {
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
+        _logger->error("Failed to delete connection from epoll");
+    }
+    close(pc->_socket);
+    if (pc->_fifo && pc->_out_socket != -1) {
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pc->_out_socket, nullptr);
+        close(pc->_out_socket);
+    }
+
+    _timers->cancel(&pc->_timer);
+    if (pc->_ready_events != 0) {
+        std::replace(_ready.begin(), _ready.end(), pc, static_cast<Connection *>(nullptr));
+        std::replace(_serving.begin(), _serving.end(), pc, static_cast<Connection *>(nullptr));
+    }
+    _connections.erase(pc);
+    _load_connections.store(_connections.size(), std::memory_order_relaxed);
+    _connection_pool.destroy(pc);
+}
+
+// See Worker.h
+void Worker::Drain() {
+    uint64_t deadline = Now() + _drain_timeout;
+
+    // Nothing new comes in: connections handed over since Stop are closed unserved, datagrams are left in
+    // the socket. Own server socket is still open as it could be passed to the next process
+    if (_server_socket != -1 && epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, _server_socket, nullptr)) {
+        _logger->error("Failed to delete server socket from epoll");
+    }
+    _udp.reset();
+    OnRegister(deadline);
+
+    // Commands that have arrived by now are the last ones executed, ready list is over
+    _ready.clear();
+    _serving.clear();
+    std::vector<Connection *> connections(_connections.begin(), _connections.end());
+    std::size_t total = connections.size();
+    for (Connection *pc : connections) {
+        pc->_ready_events = 0;
+        pc->DoRead();
+
+        // Edge triggered socket reports once it gets writable again, FIFO to read from doesn't report anything
+        pc->_event.events = pc->_fifo ? 0 : EPOLLOUT | EPOLLET;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
+            _logger->error("Failed to change connection event mask");
+            pc->OnError();
+        }
+        OnDrain(pc, 0);
+    }
+
+    std::array<struct epoll_event, 64> mod_list;
+    for (uint64_t now = Now(); !_connections.empty() && now < deadline; now = Now()) {
+        int nmod = epoll_wait(_epoll_fd, &mod_list[0], mod_list.size(), int(deadline - now));
+        for (int i = 0; i < nmod; i++) {
+            struct epoll_event &current_event = mod_list[i];
+            if (current_event.data.ptr == &_wakeup_fd) {
+                OnRegister(now);
+                continue;
             }
+            OnDrain(static_cast<Connection *>(current_event.data.ptr), current_event.events);
         }
-        // TODO: Select timeout...
     }
-    _logger->warn("Worker stopped");
+
+    std::size_t aborted = 0;
+    connections.assign(_connections.begin(), _connections.end());
+    for (Connection *pc : connections) {
+        aborted += pc->_output.empty() ? 0 : 1;
+        Close(pc);
+    }
+    if (total > 0) {
+        _logger->info("Drained {} connections, {} closed with responses unsent", total - aborted, aborted);
+    }
+}
+
+// See Worker.h
+void Worker::OnDrain(Connection *pc, uint32_t events) {
+    if (pc->_lingering) {
+        // Whatever client sends now is dropped, it learns that by EOF
+        char discard[4096];
+        ssize_t n;
+        while ((n = read(pc->_socket, discard, sizeof(discard))) > 0) {
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            pc->OnClose();
+        }
+    } else if ((events & EPOLLERR) || (events & EPOLLHUP)) {
+        pc->OnError();
+    } else if (!pc->_output.empty()) {
+        pc->DoWrite();
+    }
+
+    // Responses are sent, FIN tells client there is nothing more to come. Socket closed with unread data
+    // resets connection and client could lose responses it hasn't read yet, so wait for client to close
+    // first. FIFO has no client side to wait for
+    if (pc->isAlive() && pc->_output.empty() && !pc->_fifo && !pc->_lingering) {
+        pc->_lingering = true;
+        shutdown(pc->_socket, SHUT_WR);
+        pc->_event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
+            _logger->error("Failed to change connection event mask");
+            pc->OnError();
+        } else {
+            OnDrain(pc, 0);
+            return;
+        }
+    }
+
+    if (!pc->isAlive() || (pc->_fifo && pc->_output.empty())) {
+        Close(pc);
+    }
 }
 
 } // namespace MTnonblock
@@ -4,6 +4,18 @@
 #include <atomic>
 #include <memory>
 #include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <sys/epoll.h>
+
+#include <network/common/Backpressure.h>
+#include <network/common/Budget.h>
+#include <network/common/ChunkPool.h>
+#include <network/common/MpscQueue.h>
+#include <network/common/ObjectPool.h>
+#include <network/common/TimerWheel.h>
+#include <network/common/UdpEndpoint.h>
 
 namespace spdlog {
 class logger;
@@ -20,46 +32,175 @@ class Service;
 namespace Network {
 namespace MTnonblock {
 
+// Forward declaration, see Connection.h
+class Connection;
+
 /**
  * # Thread running epoll
  * On Start spaws background thread that is doing epoll on the given server
- * socket and process incoming connections and its data
+ * socket and process incoming connections and its data.
+ *
+ * Each connection belongs to exactly one worker and only that worker's thread touches it, so connections
+ * are registered edge triggered once and epoll_ctl is called only when connection changes its interest
+ *
+ * Every connection has a timer in the worker's wheel: it is closed if no request arrives for idle_timeout
+ * or once started request isn't received completely in read_timeout. Both are in milliseconds, 0 disables.
+ *
+ * Connection does limited work per wakeup, see Budget.h. Connections that have more to do wait in the ready
+ * list and are served round robin after the events of each epoll_wait
+ *
+ * With spin set worker polls epoll without sleeping for up to that many microseconds before it blocks, so
+ * request arriving meanwhile skips wakeup and scheduler latency. Spinning is worth the core only while events
+ * come more often than that, so worker spins only if the recent average gap between events is below spin.
+ * Gaps keep being measured while worker sleeps, so it starts to spin again once traffic gets dense
+ *
+ * On Stop worker drains: it stops accepting, executes commands that have arrived by then and stops reading.
+ * For no longer than drain_timeout milliseconds it sends queued responses, then shuts writing down and waits
+ * for client to close its side. Connections left at the deadline are closed anyway
  */
 class Worker {
 public:
-    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl);
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl,
+           uint32_t idle_timeout = 0, uint32_t read_timeout = 0, uint32_t drain_timeout = 0,
+           const Budget &budget = Budget(), uint32_t spin = 0);
     ~Worker();
 
     Worker(Worker &&);
     Worker &operator=(Worker &&);
 
     /**
-     * Spaws new background thread that is doing epoll on the given server
-     * socket. Once connection accepted it must be registered and being processed
-     * on this thread
+     * Spaws new background thread that is doing epoll on the given descriptor, worker owns it
+     * since then. Connections are given to worker by Register().
+     *
+     * If server_socket isn't negative worker runs in shared nothing mode: it accepts connections
+     * on its own server socket (one of SO_REUSEPORT group) by itself and owns the socket as well.
+     *
+     * If cpu isn't negative thread gets pinned to that CPU
+     */
+    void Start(int epoll_fd, int server_socket = -1, int cpu = -1);
+
+    /**
+     * Gives FIFO pair to the worker, it serves them as a single connection for the whole its life, see
+     * Listeners.h. Worker owns descriptors since then. Output descriptor could be -1 if responses
+     * are dropped. Must be called before Start()
+     */
+    void ServeFifo(int rfifo, int wfifo);
+
+    /**
+     * Gives datagram socket to the worker, it serves memcached UDP requests coming there, see UdpEndpoint.h.
+     * Worker owns the socket since then. Must be called before Start()
+     */
+    void ServeUdp(int socket);
+
+    /**
+     * Own server socket in shared nothing mode, -1 otherwise
+     */
+    int ServerSocket() const { return _server_socket; }
+
+    /**
+     * Number of UDP response datagrams dropped by this worker. Safe to call from any thread
+     */
+    std::size_t UdpDropped() const { return _udp_dropped.load(std::memory_order_relaxed); }
+
+    /**
+     * Hands socket accepted by some other thread over to this worker, which creates connection for it
+     * in its own thread. Worker owns the socket since then. Returns false if worker's queue is full,
+     * socket stays with the caller then. Safe to call from any thread
+     */
+    bool Register(int socket);
+
+    /**
+     * Estimated amount of work worker has: connections served and queued for it plus connection events
+     * it handles per 100 ms recently. Safe to call from any thread
      */
-    void Start(int epoll_fd);
+    uint64_t Load() const;
 
     /**
      * Signal background thread to stop. After that signal thread must stop to
      * accept new connections and must stop read new commands from existing. Once
      * all readed commands are executed and results are send back to client, thread
-     * must stop
+     * must stop. Safe to call from any thread
      */
     void Stop();
 
     /**
      * Blocks calling thread until background one for this worker is actually
-     * been destoryed
+     * been destoryed, that is until all its connections are drained. Sockets registered
+     * meanwhile are closed
      */
     void Join();
 
+    /**
+     * Backpressure counters of connections served by this worker
+     */
+    const BackpressureStats &Stats() const { return _stats; }
+
 protected:
     /**
      * Method executing by background thread
      */
     void OnRun();
 
+    /**
+     * epoll_wait that spins before sleeping if recent event rate makes it worth, see class description
+     */
+    int Poll(struct epoll_event *events, int size, int timeout);
+
+    /**
+     * Accepts all pending connections on own server socket
+     */
+    void OnAccept(uint64_t now);
+
+    /**
+     * Serves sockets queued by Register()
+     */
+    void OnRegister(uint64_t now);
+
+    /**
+     * Creates connection for the socket and adds it to epoll
+     */
+    void Attach(int socket, uint64_t now);
+
+    /**
+     * Creates connection for FIFO pair given by ServeFifo() and adds both FIFOs to epoll
+     */
+    void AttachFifo();
+
+    /**
+     * Moves connection timer after activity: idle timeout if connection waits for a new request,
+     * read deadline if request has been started
+     */
+    void Touch(Connection *pc, uint64_t now);
+
+    /**
+     * Serves events of connection, closes it or updates its registration afterwards. Queues connection
+     * to the ready list if it has spent its budget
+     */
+    void OnEvent(Connection *pc, uint32_t events, uint64_t now);
+
+    /**
+     * Sends queued responses. Socket is most likely writable, so try it right away: if it succeeds
+     * then interest doesn't change and there is no need to wait for EPOLLOUT. Connection which output
+     * drains below low watermark resumes reading
+     */
+    void Flush(Connection *pc);
+
+    /**
+     * Removes connection from epoll and destroys it
+     */
+    void Close(Connection *pc);
+
+    /**
+     * Serves connections after Stop until they send queued responses or drain timeout expires,
+     * closes all of them afterwards
+     */
+    void Drain();
+
+    /**
+     * Sends responses of draining connection, then discards its input until client closes connection
+     */
+    void OnDrain(Connection *pc, uint32_t events);
+
 private:
     Worker(Worker &) = delete;
     Worker &operator=(Worker &) = delete;
@@ -81,6 +222,85 @@ private:
 
     // EPOLL descriptor using for events processing
     int _epoll_fd;
+
+    // Own server socket in shared nothing mode, -1 otherwise. Its address is used as epoll
+    // event data to tell it from connections
+    int _server_socket;
+
+    // Event descriptor to wakeup worker once sockets are registered, its address is used as epoll
+    // event data as well
+    int _wakeup_fd;
+
+    // FIFO pair served by this worker, -1 if none
+    int _rfifo;
+    int _wfifo;
+
+    // Datagram socket served by this worker, -1 if none
+    int _udp_socket;
+
+    // CPU thread is pinned to, -1 if not pinned
+    int _cpu;
+
+    // Connection timeouts in milliseconds, 0 if disabled
+    uint32_t _idle_timeout;
+    uint32_t _read_timeout;
+
+    // Milliseconds connections have to send queued responses after Stop
+    uint32_t _drain_timeout;
+
+    // Work connection could do per wakeup
+    Budget _budget;
+
+    // Microseconds to poll epoll before sleeping, 0 disables spinning
+    uint32_t _spin;
+
+    // Sockets registered by other threads and not served yet
+    std::unique_ptr<MpscQueue<int>> _incoming;
+
+    // Worker has been woken up and is going to drain _incoming, no need to signal it again
+    std::atomic<bool> _wakeup_pending;
+
+    // Load published for acceptors: number of connections, connection events per window smoothed
+    // over recent windows and time it was updated at
+    std::atomic<uint64_t> _load_connections;
+    std::atomic<uint64_t> _load_events;
+    std::atomic<uint64_t> _load_time;
+
+    // Everything below is used by worker thread only
+
+    // Connections served by this worker
+    std::unordered_set<Connection *> _connections;
+
+    // Slots for connections served by this worker
+    ObjectPool<Connection> _connection_pool;
+
+    // IO blocks of connections served by this worker, lent to connection only while data is in flight
+    ChunkPool _chunk_pool;
+
+    // Serves datagrams of own UDP socket, its address is used as epoll event data
+    std::unique_ptr<UdpEndpoint> _udp;
+
+    // Connection timers
+    std::unique_ptr<TimerWheel> _timers;
+
+    // Time events have last been seen at and average gap between them, microseconds
+    uint64_t _last_event;
+    uint64_t _event_gap;
+
+    // Connection events handled since the current load window has started
+    uint64_t _window_events;
+    uint64_t _window_start;
+
+    // Connections to be served on the next iteration regardless of epoll, and those being served on
+    // the current one. Closed connection is replaced by nullptr
+    std::vector<Connection *> _ready;
+    std::vector<Connection *> _serving;
+
+    // Shared by connections of this worker, read by server on stats request
+    BackpressureStats _stats;
+
+    // UDP endpoint counter published for stats
+    std::atomic<std::size_t> _udp_dropped;
 };
 
 } // namespace MTnonblock
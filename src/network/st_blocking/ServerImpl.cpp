@@ -20,6 +20,7 @@
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
 #include <afina/logging/Service.h>
+#include <network/common/Tuning.h>
 
 #include "protocol/Parser.h"
 
@@ -27,6 +28,26 @@ namespace Afina {
 namespace Network {
 namespace STblocking {
 
+namespace {
+
+// Responses queued past that size are sent before the rest of the read is processed
+const std::size_t kFlushThreshold = 64 * 1024;
+
+// Sends all responses queued, more tells kernel the next ones follow shortly so it could hold partial segment
+void Flush(int socket, std::string &output, bool more) {
+    std::size_t sent = 0;
+    while (sent < output.size()) {
+        ssize_t n = send(socket, output.data() + sent, output.size() - sent, more ? MSG_MORE : 0);
+        if (n <= 0) {
+            throw std::runtime_error("Failed to send response");
+        }
+        sent += n;
+    }
+    output.clear();
+}
+
+} // namespace
+
 // See Server.h
 ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
 
@@ -34,7 +55,7 @@ ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Loggi
 ServerImpl::~ServerImpl() {}
 
 // See Server.h
-void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
+void ServerImpl::Start(const Options &options) {
     _logger = pLogging->select("network");
     _logger->info("Start st_blocking network service");
 
@@ -59,9 +80,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
     // Note we need to convert the port to network order
     struct sockaddr_in server_addr;
     std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+    server_addr.sin_family = AF_INET;           // IPv4
+    server_addr.sin_port = htons(options.port); // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY;   // Bind to any address
 
     // Arguments are:
     // - Family: IPv4
@@ -92,11 +113,13 @@ void ServerImpl::Start(uint16_t port, uint32_t n_accept, uint32_t n_workers) {
         throw std::runtime_error("Socket bind() failed");
     }
 
+    TuneListening(_server_socket, options);
+
     // Start listening. The second parameter is the "backlog", or the maximum number of
     // connections that we'll allow to queue up. Note that listen() doesn't block until
     // incoming connections arrive. It just makesthe OS aware that this process is willing
     // to accept connections on this socket (which is bound to a specific IP and port)
-    if (listen(_server_socket, 5) == -1) {
+    if (listen(_server_socket, options.backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed");
     }
@@ -128,7 +151,9 @@ void ServerImpl::OnRun() {
     std::size_t arg_remains;
     Protocol::Parser parser;
     std::string argument_for_command;
-    std::unique_ptr<Execute::Command> command_to_execute;
+    Protocol::InPlaceCommand command_to_execute;
+    // Reused by all commands to keep its capacity
+    std::string result;
     while (running.load()) {
         _logger->debug("waiting for connection...");
 
@@ -165,6 +190,8 @@ void ServerImpl::OnRun() {
         // - read commands until socket alive
         // - execute each command
         // - send response
+        // Responses not sent yet
+        std::string output;
         try {
             int readed_bytes = -1;
             char client_buffer[4096];
@@ -184,10 +211,8 @@ void ServerImpl::OnRun() {
                             // There is no command to be launched, continue to parse input stream
                             // Here we are, current chunk finished some command, process it
                             _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
-                            command_to_execute = parser.Build(arg_remains);
-                            if (arg_remains > 0) {
-                                arg_remains += 2;
-                            }
+                            command_to_execute = parser.BuildInPlace(arg_remains);
+                            arg_remains = parser.BlockSize();
                         }
 
                         // Parsed might fails to consume any bytes from input stream. In real life that could happens,
@@ -216,13 +241,16 @@ void ServerImpl::OnRun() {
                     if (command_to_execute && arg_remains == 0) {
                         _logger->debug("Start command execution");
 
-                        std::string result;
+                        parser.StripBlock(argument_for_command);
+
+                        result.clear();
                         command_to_execute->Execute(*pStorage, argument_for_command, result);
 
-                        // Send response
-                        result += "\r\n";
-                        if (send(client_socket, result.data(), result.size(), 0) <= 0) {
-                            throw std::runtime_error("Failed to send response");
+                        // Responses of commands from one read go out together
+                        output += result;
+                        output += "\r\n";
+                        if (output.size() >= kFlushThreshold) {
+                            Flush(client_socket, output, readed_bytes > 0);
                         }
 
                         // Prepare for the next command
@@ -231,6 +259,7 @@ void ServerImpl::OnRun() {
                         parser.Reset();
                     }
                 } // while (readed_bytes)
+                Flush(client_socket, output, false);
             }
 
             if (readed_bytes == 0) {
@@ -240,6 +269,11 @@ void ServerImpl::OnRun() {
             }
         } catch (std::runtime_error &ex) {
             _logger->error("Failed to process connection on descriptor {}: {}", client_socket, ex.what());
+
+            // Commands executed before the failure still get their responses
+            if (!output.empty()) {
+                send(client_socket, output.data(), output.size(), MSG_NOSIGNAL);
+            }
         }
 
         // We are done with this connection
@@ -0,0 +1,194 @@
+#include "Connection.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/execute/Command.h>
+
+#include "protocol/Parser.h"
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+
+namespace {
+
+// Responses queued past that size are sent before the rest of the read is processed
+const std::size_t kFlushThreshold = 64 * 1024;
+
+} // namespace
+
+// See Connection.h
+void Connection::Run(Connection &self) {
+    // Exception must not leave coroutine, there is no caller frame to unwind to
+    try {
+        self.Serve();
+    } catch (std::exception &ex) {
+        self._logger->error("Failed to process connection on descriptor {}: {}", self._socket, ex.what());
+
+        // Commands executed before the failure still get their responses
+        if (!self._output.empty()) {
+            self.WriteAll(self._output.data(), self._output.size());
+        }
+    }
+
+    // Event loop destroys connection once coroutine is gone
+    self._closed.push_back(&self);
+}
+
+// See Connection.h
+void Connection::Serve() {
+    // Here is connection state
+    // - parser: parse state of the stream
+    // - command_to_execute: last command parsed out of stream
+    // - arg_remains: how many bytes to read from stream to get command argument
+    // - argument_for_command: buffer stores argument
+    std::size_t arg_remains = 0;
+    Protocol::Parser parser;
+    std::string argument_for_command;
+    Protocol::InPlaceCommand command_to_execute;
+    std::string result;
+
+    ssize_t readed_bytes = -1;
+    while ((readed_bytes = Read(_buffer, sizeof(_buffer))) > 0) {
+        _logger->debug("Got {} bytes from socket", readed_bytes);
+
+        // Single block of data readed from the socket could trigger inside actions a multiple times,
+        // for example:
+        // - read#0: [<command1 start>]
+        // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+        const char *data = _buffer;
+        std::size_t size = readed_bytes;
+        while (size > 0) {
+            _logger->debug("Process {} bytes", size);
+            // There is no command yet
+            if (!command_to_execute) {
+                std::size_t parsed = 0;
+                if (parser.Parse(data, size, parsed)) {
+                    // There is no command to be launched, continue to parse input stream
+                    // Here we are, current chunk finished some command, process it
+                    _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                    command_to_execute = parser.BuildInPlace(arg_remains);
+                    arg_remains = parser.BlockSize();
+                }
+
+                // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+                // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+                if (parsed == 0) {
+                    break;
+                }
+                data += parsed;
+                size -= parsed;
+            }
+
+            // There is command, but we still wait for argument to arrive...
+            if (command_to_execute && arg_remains > 0) {
+                _logger->debug("Fill argument: {} bytes of {}", size, arg_remains);
+                // There is some parsed command, and now we are reading argument
+                std::size_t to_read = std::min(arg_remains, size);
+                argument_for_command.append(data, to_read);
+                data += to_read;
+                size -= to_read;
+                arg_remains -= to_read;
+            }
+
+            // Thre is command & argument - RUN!
+            if (command_to_execute && arg_remains == 0) {
+                _logger->debug("Start command execution");
+
+                parser.StripBlock(argument_for_command);
+
+                result.clear();
+                command_to_execute->Execute(*pStorage, argument_for_command, result);
+
+                // Responses of commands from one read go out together
+                _output += result;
+                _output += "\r\n";
+                if (_output.size() >= kFlushThreshold) {
+                    Flush(size > 0);
+                }
+
+                // Prepare for the next command
+                command_to_execute.reset();
+                argument_for_command.resize(0);
+                parser.Reset();
+            }
+        } // while (size)
+        Flush(false);
+
+        // Parser takes partial command head as well, so leftover means it got stuck
+        if (size > 0) {
+            throw std::runtime_error("Failed to parse command");
+        }
+    }
+
+    if (readed_bytes == 0) {
+        _logger->debug("Connection on descriptor {} closed by client", _socket);
+    } else {
+        throw std::runtime_error(std::string(strerror(errno)));
+    }
+}
+
+// See Connection.h
+ssize_t Connection::Read(char *buffer, std::size_t size) {
+    for (;;) {
+        ssize_t result = read(_socket, buffer, size);
+        if (result >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            return result;
+        }
+        if (!Wait()) {
+            errno = ECONNABORTED;
+            return -1;
+        }
+    }
+}
+
+// See Connection.h
+ssize_t Connection::WriteAll(const char *data, std::size_t size, bool more) {
+    std::size_t written = 0;
+    while (written < size) {
+        ssize_t result = send(_socket, data + written, size - written, MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+        if (result >= 0) {
+            written += result;
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            return -1;
+        }
+        if (!Wait()) {
+            errno = ECONNABORTED;
+            return -1;
+        }
+    }
+    return written;
+}
+
+// See Connection.h
+bool Connection::Wait() {
+    if (_stopping) {
+        return false;
+    }
+    _engine.sched(_loop);
+
+    // Even if server is stopping now the call is retried once: read reports end of stream after shutdown
+    return true;
+}
+
+// See Connection.h
+void Connection::Flush(bool more) {
+    if (WriteAll(_output.data(), _output.size(), more) < 0) {
+        throw std::runtime_error(std::string("Failed to send response: ") + strerror(errno));
+    }
+    _output.clear();
+}
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,94 @@
+#ifndef AFINA_NETWORK_ST_COROUTINE_CONNECTION_H
+#define AFINA_NETWORK_ST_COROUTINE_CONNECTION_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <afina/Storage.h>
+#include <afina/coroutine/Engine.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+
+/**
+ * # Connection served by coroutine
+ * Reads, parses, executes and writes back in blocking style like MTblocking does. Once socket isn't ready
+ * coroutine passes control to the event loop, which resumes it on the next epoll event of the socket.
+ * Resumed coroutine just retries the call, so spurious resumes are harmless
+ */
+class Connection {
+public:
+    /**
+     * @param loop event loop coroutine to pass control to while socket isn't ready
+     * @param closed connection adds itself there once done, event loop destroys it afterwards
+     */
+    Connection(int s, std::shared_ptr<spdlog::logger> l, std::shared_ptr<Afina::Storage> stg,
+               Coroutine::Engine &engine, void *&loop, std::vector<Connection *> &closed)
+        : _socket(s), _logger(l), pStorage(stg), _engine(engine), _loop(loop), _closed(closed), _routine(nullptr),
+          _stopping(false) {}
+
+    /**
+     * Coroutine body, serves connection till client closes it
+     */
+    static void Run(Connection &self);
+
+protected:
+    void Serve();
+
+    /**
+     * read(2) and write(2) that wait for the socket instead of EAGAIN. Return -1 with errno set on error,
+     * or if connection is stopping while it waits. If more is set kernel holds partial segment as the next
+     * data follows shortly
+     */
+    ssize_t Read(char *buffer, std::size_t size);
+    ssize_t WriteAll(const char *data, std::size_t size, bool more = false);
+
+    /**
+     * Sends responses queued so far, throws if that fails
+     */
+    void Flush(bool more);
+
+    /**
+     * Passes control to the event loop until something happens with the socket. Returns false if
+     * connection should give up instead of waiting further
+     */
+    bool Wait();
+
+private:
+    friend class ServerImpl;
+
+    int _socket;
+
+    std::shared_ptr<spdlog::logger> _logger;
+    std::shared_ptr<Afina::Storage> pStorage;
+
+    Coroutine::Engine &_engine;
+    void *&_loop;
+    std::vector<Connection *> &_closed;
+
+    // Coroutine serving connection
+    void *_routine;
+
+    // Server is going down, connection must not wait for the socket anymore
+    bool _stopping;
+
+    // Kept out of coroutine stack, engine copies the whole stack on every switch
+    char _buffer[4096];
+
+    // Responses of commands from the current read, sent together once it is processed
+    std::string _output;
+};
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_ST_COROUTINE_CONNECTION_H
@@ -0,0 +1,231 @@
+#include "ServerImpl.h"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/logging/Service.h>
+#include <network/common/Tuning.h>
+
+#include "Connection.h"
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
+    : Server(ps, pl), _server_socket(-1), _event_fd(-1), _epoll_fd(-1), _loop(nullptr) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(const Options &options) {
+    _logger = pLogging->select("network");
+    _logger->info("Start st_coroutine network service");
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    // Create server socket
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;           // IPv4
+    server_addr.sin_port = htons(options.port); // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY;   // Bind to any address
+
+    _server_socket = socket(PF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP);
+    if (_server_socket == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    int opts = 1;
+    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    }
+
+    TuneListening(_server_socket, options);
+
+    if (listen(_server_socket, options.backlog) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    }
+
+    _event_fd = eventfd(0, EFD_NONBLOCK);
+    if (_event_fd == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Failed to create event file descriptor: " + std::string(strerror(errno)));
+    }
+
+    _epoll_fd = epoll_create1(0);
+    if (_epoll_fd == -1) {
+        close(_server_socket);
+        close(_event_fd);
+        throw std::runtime_error("Failed to create epoll file descriptor: " + std::string(strerror(errno)));
+    }
+
+    // Server socket and eventfd are told apart from connections by the address of the member
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &_server_socket;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _server_socket, &event)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
+    event.events = EPOLLIN;
+    event.data.ptr = &_event_fd;
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _event_fd, &event)) {
+        throw std::runtime_error("Failed to add file descriptor to epoll");
+    }
+
+    _work_thread = std::thread(&ServerImpl::OnRun, this);
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    _logger->warn("Stop network service");
+
+    // Wakeup thread that is sleep on epoll_wait
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup workers");
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    // Wait for work to be complete
+    if (_work_thread.joinable()) {
+        _work_thread.join();
+    }
+
+    close(_server_socket);
+    close(_event_fd);
+    close(_epoll_fd);
+}
+
+// See ServerImpl.h
+void ServerImpl::OnRun() {
+    _logger->info("Start coroutine engine");
+    _engine.start(&ServerImpl::OnStart, *this);
+    _logger->warn("Network stopped");
+}
+
+// See ServerImpl.h
+void ServerImpl::OnStart(ServerImpl &self) { self._loop = self._engine.run(&ServerImpl::OnLoop, self); }
+
+// See ServerImpl.h
+void ServerImpl::OnLoop(ServerImpl &self) {
+    // Exception must not leave coroutine, connections are shut down in any case
+    try {
+        // Kept small, engine copies loop stack on every switch
+        std::array<struct epoll_event, 16> mod_list;
+        for (bool run = true; run;) {
+            int nmod = epoll_wait(self._epoll_fd, &mod_list[0], mod_list.size(), -1);
+            if (nmod == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to wait for events: " + std::string(strerror(errno)));
+            }
+            self._logger->debug("Event loop wokeup: {} events", nmod);
+
+            for (int i = 0; i < nmod; i++) {
+                void *ptr = mod_list[i].data.ptr;
+                if (ptr == &self._event_fd) {
+                    self._logger->debug("Break event loop due to stop signal");
+                    run = false;
+                } else if (ptr == &self._server_socket) {
+                    self.OnNewConnection();
+                } else {
+                    // Connection might be gone already due to spurious resume by the engine
+                    Connection *pc = static_cast<Connection *>(ptr);
+                    if (self._connections.count(pc) > 0) {
+                        self._engine.sched(pc->_routine);
+                        self.Collect();
+                    }
+                }
+            }
+        }
+    } catch (std::exception &ex) {
+        self._logger->error("Event loop failed: {}", ex.what());
+    }
+
+    // Let every coroutine finish: reading returns end of stream, waiting for the socket fails
+    std::vector<Connection *> alive(self._connections.begin(), self._connections.end());
+    for (Connection *pc : alive) {
+        pc->_stopping = true;
+        shutdown(pc->_socket, SHUT_RD);
+    }
+    while (!self._connections.empty()) {
+        self._engine.sched((*self._connections.begin())->_routine);
+        self.Collect();
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::OnNewConnection() {
+    for (;;) {
+        int client_socket = accept4(_server_socket, nullptr, nullptr, SOCK_NONBLOCK);
+        if (client_socket == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                _logger->error("Failed to accept socket: {}", strerror(errno));
+            }
+            break;
+        }
+
+        Connection *pc = new Connection(client_socket, _logger, pStorage, _engine, _loop, _closed);
+
+        // Edge triggered: coroutine reads and writes till EAGAIN anyway
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = pc;
+        if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, client_socket, &event)) {
+            _logger->error("Failed to register connection on descriptor {}", client_socket);
+            close(client_socket);
+            delete pc;
+            continue;
+        }
+
+        _connections.insert(pc);
+        pc->_routine = _engine.run(&Connection::Run, *pc);
+        _engine.sched(pc->_routine);
+        Collect();
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::Collect() {
+    for (Connection *pc : _closed) {
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pc->_socket, nullptr);
+        close(pc->_socket);
+        _connections.erase(pc);
+        delete pc;
+    }
+    _closed.clear();
+}
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,101 @@
+#ifndef AFINA_NETWORK_ST_COROUTINE_SERVER_H
+#define AFINA_NETWORK_ST_COROUTINE_SERVER_H
+
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <afina/coroutine/Engine.h>
+#include <afina/network/Server.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+namespace Network {
+namespace STcoroutine {
+
+// Forward declaration, see Connection.h
+class Connection;
+
+/**
+ * # Network resource manager implementation
+ * Single threaded server, each connection is served by its own coroutine written in blocking style.
+ * Event loop is a coroutine as well: it waits on epoll and passes control to connection which socket
+ * got an event, connection passes it back once socket isn't ready anymore
+ */
+class ServerImpl : public Server {
+public:
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    ~ServerImpl();
+
+    // See Server.h
+    void Start(const Options &options) override;
+
+    // See Server.h
+    void Stop() override;
+
+    // See Server.h
+    void Join() override;
+
+protected:
+    /**
+     * Method executing by IO thread, runs coroutine engine till all coroutines are done
+     */
+    void OnRun();
+
+    /**
+     * Main coroutine, starts event loop one and leaves, so the loop has known handle connections
+     * could pass control to
+     */
+    static void OnStart(ServerImpl &self);
+
+    /**
+     * Event loop coroutine
+     */
+    static void OnLoop(ServerImpl &self);
+
+    /**
+     * Accepts all pending connections and starts coroutine for each
+     */
+    void OnNewConnection();
+
+    /**
+     * Destroys connections which coroutines are done
+     */
+    void Collect();
+
+private:
+    // logger to use
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Socket to accept new connection on
+    int _server_socket;
+
+    // Curstom event "device" used to wakeup IO thread
+    int _event_fd;
+
+    // EPOLL descriptor of event loop
+    int _epoll_fd;
+
+    // IO thread
+    std::thread _work_thread;
+
+    // Everything below is used by IO thread only
+    Coroutine::Engine _engine;
+
+    // Event loop coroutine
+    void *_loop;
+
+    std::unordered_set<Connection *> _connections;
+
+    // Connections which coroutines are done
+    std::vector<Connection *> _closed;
+};
+
+} // namespace STcoroutine
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_ST_COROUTINE_SERVER_H
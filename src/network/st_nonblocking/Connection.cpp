@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <iostream>
+#include <stdexcept>
 #include <sys/socket.h>
 #include <sys/uio.h>
 namespace Afina {
@@ -10,7 +11,7 @@ namespace STnonblock {
 
 // See Connection.h
 void Connection::Start() {
-    _logger->info("Start st_nonblocking network connection on descriptor {} \n", _socket);
+    _logger->debug("Start st_nonblocking network connection on descriptor {} \n", _socket);
     _is_alive = true;
     _event.events = EPOLLIN | EPOLLPRI | EPOLLRDHUP;
 
@@ -20,9 +21,11 @@ void Connection::Start() {
     arg_remains = 0;
 
     // Prepare for reading
-    _written_bytes = 0;
-    _read_bytes = 0;
-    _results.clear();
+    _reading_paused = false;
+    _has_more = false;
+    _eof = false;
+    _input.clear();
+    _output.clear();
     _event.data.ptr = this;
 }
 
@@ -42,106 +45,162 @@ void Connection::OnClose() {
 void Connection::DoRead() {
     _logger->debug("Read from connection on descriptor {} \n", _socket);
     int client_socket = _socket;
-    command_to_execute = nullptr;
     try {
-        _bytes_for_read = 0;
-        while ((_bytes_for_read =
-                    read(client_socket, client_buffer + _read_bytes, sizeof(client_buffer) - _read_bytes)) > 0) {
-            _logger->debug("Got {} bytes from socket", _bytes_for_read);
-            _read_bytes += _bytes_for_read;
-            while (_read_bytes > 0) {
-                _logger->debug("Process {} bytes", _read_bytes);
-                // There is no command yet
-                if (!command_to_execute) {
-                    std::size_t parsed = 0;
-                    if (parser.Parse(client_buffer, _read_bytes, parsed)) {
-                        // There is no command to be launched, continue to parse input stream
-                        // Here we are, current chunk finished some command, process it
-                        _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
-                        command_to_execute = parser.Build(arg_remains);
-                        if (arg_remains > 0) {
-                            arg_remains += 2;
-                        }
-                    }
-
-                    // Parsed might fails to consume any bytes from input stream. In real life that could happens,
-                    // for example, because we are working with UTF-16 chars and only 1 byte left in stream
-                    if (parsed == 0) {
-                        break;
-                    } else {
-                        std::memmove(client_buffer, client_buffer + parsed, _read_bytes - parsed);
-                        _read_bytes -= parsed;
-                    }
+        _commands_done = 0;
+        _bytes_read = 0;
+
+        // Input left since reading was paused or budget was spent goes first
+        Process();
+        while (_is_alive && !_reading_paused && !Exhausted()) {
+            // Socket data goes straight to the tail of input chain, so command of any size fits in
+            std::size_t space = 0;
+            char *tail = _input.prepare(space);
+            ssize_t readed_bytes = read(client_socket, tail, space);
+            if (readed_bytes == 0) {
+                _logger->debug("Connection on descriptor {} closed by client", client_socket);
+                _eof = true;
+                break;
+            } else if (readed_bytes < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    // EAGAIN - Resource temporarily unvailable
+                    _logger->debug("Client stop to write to connection on descriptor {}", client_socket);
+                    break;
                 }
+                throw std::runtime_error(std::string(strerror(errno)));
+            }
 
-                // There is command, but we still wait for argument to arrive...
-                if (command_to_execute && arg_remains > 0) {
-                    _logger->debug("Fill argument: {} bytes of {}", _read_bytes, arg_remains);
-                    // There is some parsed command, and now we are reading argument
-                    std::size_t to_read = std::min(arg_remains, std::size_t(_read_bytes));
-                    argument_for_command.append(client_buffer, to_read);
-                    std::memmove(client_buffer, client_buffer + to_read, _read_bytes - to_read);
-                    arg_remains -= to_read;
-                    _read_bytes -= to_read;
-                }
-
-                // Thre is command & argument - RUN!
-                if (command_to_execute && arg_remains == 0) {
-                    _logger->debug("Start command execution");
-
-                    std::string result;
-                    command_to_execute->Execute(*pStorage, argument_for_command, result);
-                    bool fuckingflag = _results.empty();
-                    // Send response
-                    result += "\r\n";
-                    _results.push_back(result);
-                    if (fuckingflag) {
-                        _event.events |= EPOLLOUT;
-                    };
-
-                    // Prepare for the next command
-                    command_to_execute.reset();
-                    argument_for_command.resize(0);
-                    parser.Reset();
-                }
-            } // while (readed_bytes)
+            _logger->debug("Got {} bytes from socket", readed_bytes);
+            _input.commit(readed_bytes);
+            _bytes_read += readed_bytes;
+            Process();
         }
-        // EAGAIN - Resource temporarily unvailable
-        _logger->debug("Client stop to write to connection on descriptor {}", client_socket);
-        if (errno == EAGAIN) {
-            throw std::runtime_error(std::string(strerror(errno)));
+
+        // Socket isn't drained yet or some commands are left in the input, event loop should come back
+        // once others get their turn
+        _has_more = _is_alive && !_reading_paused && Exhausted();
+
+        // Connection waits for the next request, give borrowed memory back until it arrives
+        if (!_has_more && _input.empty()) {
+            _input.clear();
+            if (!command_to_execute) {
+                std::string().swap(argument_for_command);
+            }
+            std::string().swap(result_of_command);
         }
     } catch (std::runtime_error &ex) {
         _logger->error("failed to read from connection on descriptor {}: {}", client_socket, ex.what());
+        // Unparsed bytes stay in the input, there is no way to resync with the client
+        _is_alive = false;
+    }
+}
+
+// See Connection.h
+void Connection::Process() {
+    // Single block of data readed from the socket could trigger inside actions a multiple times,
+    // for example:
+    // - read#0: [<command1 start>]
+    // - read#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+    std::size_t size = 0;
+    const char *data;
+    while (_is_alive && !_reading_paused && !Exhausted() && (data = _input.peek(size)) != nullptr) {
+        _logger->debug("Process {} bytes", size);
+        // There is no command yet
+        if (!command_to_execute) {
+            std::size_t parsed = 0;
+            if (parser.Parse(data, size, parsed)) {
+                // There is no command to be launched, continue to parse input stream
+                // Here we are, current chunk finished some command, process it
+                _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                command_to_execute = parser.BuildInPlace(arg_remains);
+                arg_remains = parser.BlockSize();
+            }
+
+            // Parsed might fails to consume any bytes from input stream. In real life that could happens,
+            // for example, because we are working with UTF-16 chars and only 1 byte left in stream
+            if (parsed == 0) {
+                break;
+            }
+            _input.consume(parsed);
+            data += parsed;
+            size -= parsed;
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (command_to_execute && arg_remains > 0) {
+            _logger->debug("Fill argument: {} bytes of {}", size, arg_remains);
+            // There is some parsed command, and now we are reading argument
+            std::size_t to_read = std::min(arg_remains, size);
+            argument_for_command.append(data, to_read);
+            _input.consume(to_read);
+            arg_remains -= to_read;
+        }
+
+        // Thre is command & argument - RUN!
+        if (command_to_execute && arg_remains == 0) {
+            _logger->debug("Start command execution");
+
+            parser.StripBlock(argument_for_command);
+
+            result_of_command.clear();
+            command_to_execute->Execute(*pStorage, argument_for_command, result_of_command);
+            // Responses of the whole batch go out by a single write once it is processed, see ServerImpl::OnEvent.
+            // EPOLLOUT is requested only if socket doesn't take them all
+            _output.append(result_of_command);
+            _output.append("\r\n", 2);
+
+            // Prepare for the next command
+            _commands_done++;
+            command_to_execute.reset();
+            argument_for_command.resize(0);
+            parser.Reset();
+
+            // Client doesn't read responses, stop to read its commands until it does
+            if (_output.size() > kOutputHardLimit) {
+                _logger->warn("Output of connection on descriptor {} exceeds {} bytes, disconnect", _socket,
+                              kOutputHardLimit);
+                _stats.overflows++;
+                _is_alive = false;
+            } else if (_output.size() > kOutputHighWatermark) {
+                _logger->debug("Pause reading from connection on descriptor {}", _socket);
+                _stats.paused++;
+                _reading_paused = true;
+                _event.events &= ~(EPOLLIN | EPOLLPRI);
+            }
+        }
     }
 }
 
 // See Connection.h
 void Connection::DoWrite() {
-    assert(!_results.empty());
+    assert(!_output.empty());
     _logger->debug("Writing in connection on descriptor {} \n", _socket);
     try {
-        std::size_t size = _results.size();
-        auto it = _results.begin();
-        struct iovec iov[size];
-        for (std::size_t i = 0; i < size; ++i, ++it) {
-            iov[i].iov_base = &(*it)[0]; // begin of string, which in vector;
-            iov[i].iov_len = (*it).size();
+        // Each writev flushes as many queued blocks as it takes, they go until socket is full. Partial write
+        // resumes from where it stopped on the next call
+        ssize_t written;
+        do {
+            written = _output.write(_socket);
+        } while (written > 0 && !_output.empty());
+        if (written == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Wait until socket gets writable
+                _event.events |= EPOLLOUT;
+                return;
+            }
+            throw std::runtime_error(std::string(strerror(errno)));
         }
-        iov[0].iov_base = (char *)iov[0].iov_base + _written_bytes;
-        iov[0].iov_len -= _written_bytes;
-
-        int written = writev(_socket, iov, size); 
-        _written_bytes += written;
-        it = _results.begin();
-        while (it != _results.end() && _written_bytes >= it->size()) {
-            _written_bytes -= it->size();
-            ++it;
+
+        if (_reading_paused && _output.size() <= kOutputLowWatermark) {
+            _logger->debug("Resume reading from connection on descriptor {}", _socket);
+            _stats.resumed++;
+            _reading_paused = false;
+            _event.events |= EPOLLIN | EPOLLPRI;
         }
 
-        _results.erase(_results.begin(), it);
-        if (_results.empty()) {
-            _event.events = (EPOLLIN | EPOLLRDHUP);
+        if (_output.empty()) {
+            _event.events = EPOLLIN | EPOLLRDHUP;
+        } else {
+            _event.events |= EPOLLOUT;
         }
     } catch (std::runtime_error &ex) {
         _logger->error("Failed to writing to connection on descriptor {}: {} \n", _socket, ex.what());
@@ -8,6 +8,10 @@
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
 #include <afina/execute/Command.h>
+#include <network/common/Backpressure.h>
+#include <network/common/Budget.h>
+#include <network/common/InputBuffer.h>
+#include <network/common/OutputBuffer.h>
 #include <protocol/Parser.h>
 #include <sys/epoll.h>
 
@@ -17,8 +21,10 @@ namespace STnonblock {
 
 class Connection {
 public:
-    Connection(int s, std::shared_ptr<spdlog::logger> l, std::shared_ptr<Afina::Storage> stg)
-    : _socket(s), _logger(l), pStorage(stg) {
+    Connection(int s, std::shared_ptr<spdlog::logger> l, std::shared_ptr<Afina::Storage> stg, ChunkPool &pool,
+               BackpressureStats &stats, const Budget &budget)
+    : _socket(s), _logger(l), pStorage(stg), _input(pool), _output(pool), _reading_paused(false), _stats(stats),
+          _budget(budget), _commands_done(0), _bytes_read(0), _has_more(false), _ready_events(0), _lingering(false), _eof(false) {
         std::memset(&_event, 0, sizeof(struct epoll_event));
         _event.data.ptr = this;
     }
@@ -33,6 +39,20 @@ protected:
     void DoRead();
     void DoWrite();
 
+    /**
+     * Executes commands from the input buffer until it runs out, reading gets paused or budget
+     * is spent
+     */
+    void Process();
+
+    /**
+     * True once connection has done all the work allowed for the current wakeup
+     */
+    inline bool Exhausted() const {
+        return (_budget.commands > 0 && _commands_done >= _budget.commands) ||
+               (_budget.bytes > 0 && _bytes_read >= _budget.bytes);
+    }
+
 private:
     friend class ServerImpl;
 
@@ -42,16 +62,38 @@ private:
 
     std::shared_ptr<spdlog::logger> _logger;
     std::shared_ptr<Afina::Storage> pStorage;
-    std::unique_ptr<Afina::Execute::Command> command_to_execute;
-    std::vector<std::string> _results;
+    Protocol::InPlaceCommand command_to_execute;
     Protocol::Parser parser;
     std::size_t arg_remains;
     std::string argument_for_command;
+    // Reused by commands of one burst to keep its capacity
+    std::string result_of_command;
+
+    // Received and sent data, blocks are borrowed from the pool of the thread serving connection
+    // only while there is something to keep
+    InputBuffer _input;
+    OutputBuffer _output;
+
+    // Output is above high watermark, connection doesn't read until it drains
+    bool _reading_paused;
+    BackpressureStats &_stats;
+
+    // Work allowed per wakeup and spent on the current one
+    const Budget _budget;
+    uint32_t _commands_done;
+    std::size_t _bytes_read;
+
+    // Budget is spent while input may be left, either buffered or in the socket
+    bool _has_more;
+
+    // Events to serve on the next turn of event loop, 0 if connection isn't in its ready list
+    uint32_t _ready_events;
+
+    // Server is stopping and all responses are sent, connection waits for client to close its side
+    bool _lingering;
 
-    int _written_bytes;
-    int _read_bytes;
-    int _bytes_for_read;
-    char client_buffer[4096];
+    // Client has shut down its sending side, connection is closed once what it has sent is answered
+    bool _eof;
 };
 
 } // namespace STnonblock
@@ -1,13 +1,14 @@
 #include "ServerImpl.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 
 #include <arpa/inet.h>
-#include <netdb.h>
 #include <netinet/in.h>
 #include <signal.h>
 #include <sys/epoll.h>
@@ -20,6 +21,8 @@
 
 #include <afina/Storage.h>
 #include <afina/logging/Service.h>
+#include <network/common/Peer.h>
+#include <network/common/Tuning.h>
 
 #include "Connection.h"
 #include "Utils.h"
@@ -29,13 +32,15 @@ namespace Network {
 namespace STnonblock {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl) : Server(ps, pl) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+                       const Budget &budget, uint32_t drain_timeout)
+    : Server(ps, pl), _budget(budget), _drain_timeout(drain_timeout) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() {}
 
 // See Server.h
-void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers) {
+void ServerImpl::Start(const Options &options) {
     _logger = pLogging->select("network");
     _logger->info("Start st_nonblocking network service");
 
@@ -49,9 +54,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     // Create server socket
     struct sockaddr_in server_addr;
     std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;         // IPv4
-    server_addr.sin_port = htons(port);       // TCP port number
-    server_addr.sin_addr.s_addr = INADDR_ANY; // Bind to any address
+    server_addr.sin_family = AF_INET;           // IPv4
+    server_addr.sin_port = htons(options.port); // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY;   // Bind to any address
 
     _server_socket = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
     if (_server_socket == -1) {
@@ -70,7 +75,9 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
     }
 
     make_socket_non_blocking(_server_socket);
-    if (listen(_server_socket, 5) == -1) {
+    TuneListening(_server_socket, options);
+
+    if (listen(_server_socket, options.backlog) == -1) {
         close(_server_socket);
         throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
     }
@@ -87,21 +94,25 @@ void ServerImpl::Start(uint16_t port, uint32_t n_acceptors, uint32_t n_workers)
 void ServerImpl::Stop() {
     _logger->warn("Stop network service");
 
-    // Wakeup threads that are sleep on epoll_wait
+    // Wakeup threads that are sleep on epoll_wait, server socket is closed by IO thread as it
+    // may be in use right now
     if (eventfd_write(_event_fd, 1)) {
         throw std::runtime_error("Failed to wakeup workers");
     }
-    for(auto it: _connections){
-        close(it->_socket);
-        delete it;
-    }
-    close(_server_socket);
 }
 
 // See Server.h
 void ServerImpl::Join() {
     // Wait for work to be complete
     _work_thread.join();
+    close(_event_fd);
+}
+
+// See Server.h
+void ServerImpl::Stats(std::vector<std::pair<std::string, std::size_t>> &stats) const {
+    stats.emplace_back("output_paused", _stats.paused.load());
+    stats.emplace_back("output_resumed", _stats.resumed.load());
+    stats.emplace_back("output_overflows", _stats.overflows.load());
 }
 
 // See ServerImpl.h
@@ -129,8 +140,10 @@ void ServerImpl::OnRun() {
     bool run = true;
     std::array<struct epoll_event, 64> mod_list;
     while (run) {
-        int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), -1);
+        // Don't sleep while some connections are ready
+        int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), _ready.empty() ? -1 : 0);
         _logger->debug("Acceptor wokeup: {} events", nmod);
+        _serving.swap(_ready);
 
         for (int i = 0; i < nmod; i++) {
             struct epoll_event &current_event = mod_list[i];
@@ -145,55 +158,191 @@ void ServerImpl::OnRun() {
 
             // That is some connection!
             Connection *pc = static_cast<Connection *>(current_event.data.ptr);
+            uint32_t events = current_event.events;
+            if (pc->_ready_events != 0) {
+                // Connection is going to be read from the ready list anyway
+                pc->_ready_events |= events & EPOLLRDHUP;
+                events &= ~(EPOLLIN | EPOLLRDHUP);
+            }
+            OnEvent(epoll_descr, pc, events);
+        }
 
-            auto old_mask = pc->_event.events;
-            if ((current_event.events & EPOLLERR) || (current_event.events & EPOLLHUP)) {
-                pc->OnError();
-            } else if (current_event.events & EPOLLRDHUP) {
-                pc->OnClose();
-            } else {
-                // Depends on what connection wants...
-                if (current_event.events & EPOLLIN) {
-                    pc->DoRead();
-                }
-                if (current_event.events & EPOLLOUT) {
-                    pc->DoWrite();
-                }
+        // Connections that spent their budget on the previous iteration get their next turn after everyone
+        // else got theirs
+        for (Connection *pc : _serving) {
+            if (pc != nullptr) {
+                uint32_t events = pc->_ready_events;
+                pc->_ready_events = 0;
+                OnEvent(epoll_descr, pc, events);
             }
+        }
+        _serving.clear();
+    }
 
-            // Does it alive?
-            if (!pc->isAlive()) {
-                if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to delete connection from epoll");
-                }
+    // Connections buffers belong to this thread's pool, so release them here rather than in Stop
+    Drain(epoll_descr);
+    close(epoll_descr);
+    _logger->warn("Acceptor stopped");
+}
 
-                close(pc->_socket);
+// See ServerImpl.h
+void ServerImpl::OnEvent(int epoll_descr, Connection *pc, uint32_t events) {
+    auto old_mask = pc->_event.events;
+    if ((events & EPOLLERR) || (events & EPOLLHUP)) {
+        pc->OnError();
+    } else {
+        // Depends on what connection wants... Client that has shut down its sending side still waits
+        // for responses, so EPOLLRDHUP is served as the last portion of input
+        if (events & (EPOLLIN | EPOLLRDHUP)) {
+            pc->DoRead();
+        }
+
+        // Socket is most likely writable, so responses of the batch just processed go out right away
+        // rather than on the next wakeup
+        while (pc->isAlive() && !pc->_output.empty()) {
+            bool paused = pc->_reading_paused;
+            pc->DoWrite();
+            if (!paused || pc->_reading_paused) {
+                break;
+            }
+
+            // Commands received before reading has been paused wait in the input buffer,
+            // socket may have nothing new to report them
+            pc->DoRead();
+        }
+
+        // Socket stays readable at EOF, so only writability is of interest once client is done
+        if (pc->isAlive() && pc->_eof) {
+            if (pc->_output.empty() && !pc->_has_more) {
                 pc->OnClose();
-                _connections.erase(pc);
-                delete pc;
-            } else if (pc->_event.events != old_mask) {
-                if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
-                    _logger->error("Failed to change connection event mask");
-
-                    close(pc->_socket);
-                    pc->OnClose();
-                    _connections.erase(pc);
-                    delete pc;
-                }
+            } else {
+                pc->_event.events = pc->_output.empty() ? 0 : uint32_t(EPOLLOUT);
             }
         }
     }
-    _logger->warn("Acceptor stopped");
+
+    // Does it alive?
+    if (!pc->isAlive()) {
+        Close(epoll_descr, pc);
+        return;
+    } else if (pc->_event.events != old_mask) {
+        if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
+            _logger->error("Failed to change connection event mask");
+            Close(epoll_descr, pc);
+            return;
+        }
+    }
+
+    // Commands left in the input won't be reported by epoll, so queue connection to serve them
+    if (pc->_has_more) {
+        if (pc->_ready_events == 0) {
+            _ready.push_back(pc);
+        }
+        pc->_ready_events |= EPOLLIN;
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::Close(int epoll_descr, Connection *pc) {
+    if (epoll_ctl(epoll_descr, EPOLL_CTL_DEL, pc->_socket, &pc->_event)) {
+        _logger->error("Failed to delete connection from epoll");
+    }
+
+    close(pc->_socket);
+    pc->OnClose();
+    if (pc->_ready_events != 0) {
+        std::replace(_ready.begin(), _ready.end(), pc, static_cast<Connection *>(nullptr));
+        std::replace(_serving.begin(), _serving.end(), pc, static_cast<Connection *>(nullptr));
+    }
+    _connections.erase(pc);
+    _connection_pool.destroy(pc);
+}
+
+// See ServerImpl.h
+void ServerImpl::Drain(int epoll_descr) {
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(_drain_timeout);
+
+    // Stop signal stays set, so both descriptors leave epoll
+    epoll_ctl(epoll_descr, EPOLL_CTL_DEL, _event_fd, nullptr);
+    epoll_ctl(epoll_descr, EPOLL_CTL_DEL, _server_socket, nullptr);
+    close(_server_socket);
+
+    // Commands that have arrived by now are the last ones executed
+    _ready.clear();
+    _serving.clear();
+    std::vector<Connection *> connections(_connections.begin(), _connections.end());
+    std::size_t total = connections.size();
+    for (Connection *pc : connections) {
+        pc->_ready_events = 0;
+        pc->DoRead();
+
+        pc->_event.events = EPOLLOUT;
+        if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
+            _logger->error("Failed to change connection event mask");
+            pc->OnError();
+        }
+        OnDrain(epoll_descr, pc, 0);
+    }
+
+    std::array<struct epoll_event, 64> mod_list;
+    for (auto now = std::chrono::steady_clock::now(); !_connections.empty() && now < deadline;
+         now = std::chrono::steady_clock::now()) {
+        int timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+        int nmod = epoll_wait(epoll_descr, &mod_list[0], mod_list.size(), timeout);
+        for (int i = 0; i < nmod; i++) {
+            OnDrain(epoll_descr, static_cast<Connection *>(mod_list[i].data.ptr), mod_list[i].events);
+        }
+    }
+
+    std::size_t aborted = 0;
+    connections.assign(_connections.begin(), _connections.end());
+    for (Connection *pc : connections) {
+        aborted += pc->_output.empty() ? 0 : 1;
+        Close(epoll_descr, pc);
+    }
+    if (total > 0) {
+        _logger->info("Drained {} connections, {} closed with responses unsent", total - aborted, aborted);
+    }
+}
+
+// See ServerImpl.h
+void ServerImpl::OnDrain(int epoll_descr, Connection *pc, uint32_t events) {
+    if (pc->_lingering) {
+        // Whatever client sends now is dropped, it learns that by EOF
+        char discard[4096];
+        ssize_t n = read(pc->_socket, discard, sizeof(discard));
+        if (n == 0 || (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            pc->OnClose();
+        }
+    } else if ((events & EPOLLERR) || (events & EPOLLHUP)) {
+        pc->OnError();
+    } else if (!pc->_output.empty()) {
+        pc->DoWrite();
+    }
+
+    // Responses are sent, FIN tells client there is nothing more to come. Socket closed with unread data
+    // resets connection and client could lose responses it hasn't read yet, so wait for client to close first
+    if (pc->isAlive() && pc->_output.empty() && !pc->_lingering) {
+        pc->_lingering = true;
+        shutdown(pc->_socket, SHUT_WR);
+        pc->_event.events = EPOLLIN | EPOLLRDHUP;
+        if (epoll_ctl(epoll_descr, EPOLL_CTL_MOD, pc->_socket, &pc->_event)) {
+            _logger->error("Failed to change connection event mask");
+            pc->OnError();
+        }
+    }
+
+    if (!pc->isAlive()) {
+        Close(epoll_descr, pc);
+    }
 }
 
 void ServerImpl::OnNewConnection(int epoll_descr) {
     for (;;) {
-        struct sockaddr in_addr;
-        socklen_t in_len;
-
-        // No need to make these sockets non blocking since accept4() takes care of it.
-        in_len = sizeof in_addr;
-        int infd = accept4(_server_socket, &in_addr, &in_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        // No need to make these sockets non blocking since accept4() takes care of it. Peer address is
+        // not copied out, it is asked for only if gets logged
+        int infd = accept4(_server_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
         if (infd == -1) {
             if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
                 break; // We have processed all incoming connections.
@@ -203,26 +352,19 @@ void ServerImpl::OnNewConnection(int epoll_descr) {
             }
         }
 
-        // Print host and service info.
-        char hbuf[NI_MAXHOST], sbuf[NI_MAXSERV];
-        int retval =
-            getnameinfo(&in_addr, in_len, hbuf, sizeof hbuf, sbuf, sizeof sbuf, NI_NUMERICHOST | NI_NUMERICSERV);
-        if (retval == 0) {
-            _logger->info("Accepted connection on descriptor {} (host={}, port={})\n", infd, hbuf, sbuf);
+        if (_logger->should_log(spdlog::level::debug)) {
+            _logger->debug("Accepted connection on descriptor {} from {}", infd, PeerName(infd));
         }
 
         // Register the new FD to be monitored by epoll.
-        Connection *pc = new Connection(infd,_logger, pStorage);
-        if (pc == nullptr) {
-            throw std::runtime_error("Failed to allocate connection");
-        }
+        Connection *pc = _connection_pool.make(infd, _logger, pStorage, _chunk_pool, _stats, _budget);
 
         // Register connection in worker's epoll
         pc->Start();
         if (pc->isAlive()) {
             if (epoll_ctl(epoll_descr, EPOLL_CTL_ADD, pc->_socket, &pc->_event)) {
                 pc->OnError();
-                delete pc;
+                _connection_pool.destroy(pc);
             }else{
                 _connections.insert(pc);
             }
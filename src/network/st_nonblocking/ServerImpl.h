@@ -3,8 +3,11 @@
 
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include <afina/network/Server.h>
+#include <network/common/ObjectPool.h>
+
 #include "Connection.h"
 
 namespace spdlog {
@@ -24,11 +27,16 @@ class Worker;
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl);
+    /**
+     * @param budget work connection could do per wakeup
+     * @param drain_timeout milliseconds connections have to send queued responses on Stop
+     */
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl,
+               const Budget &budget = Budget(), uint32_t drain_timeout = 0);
     ~ServerImpl();
 
     // See Server.h
-    void Start(uint16_t port, uint32_t acceptors, uint32_t workers) override;
+    void Start(const Options &options) override;
 
     // See Server.h
     void Stop() override;
@@ -36,10 +44,36 @@ public:
     // See Server.h
     void Join() override;
 
+    // See Server.h
+    void Stats(std::vector<std::pair<std::string, std::size_t>> &stats) const override;
+
 protected:
     void OnRun();
     void OnNewConnection(int);
 
+    /**
+     * Serves events of connection, closes it or updates its registration afterwards. Queues connection
+     * to the ready list if it has spent its budget
+     */
+    void OnEvent(int epoll_descr, Connection *pc, uint32_t events);
+
+    /**
+     * Removes connection from epoll and destroys it
+     */
+    void Close(int epoll_descr, Connection *pc);
+
+    /**
+     * Serves connections after Stop: commands that have arrived by then are executed, nothing is read
+     * afterwards. Until drain timeout expires queued responses are sent, then writing is shut down and
+     * connection waits for client to close its side. Connections left at the deadline are closed anyway
+     */
+    void Drain(int epoll_descr);
+
+    /**
+     * Sends responses of draining connection, then discards its input until client closes connection
+     */
+    void OnDrain(int epoll_descr, Connection *pc, uint32_t events);
+
 private:
     // logger to use
     std::shared_ptr<spdlog::logger> _logger;
@@ -59,6 +93,26 @@ private:
     std::thread _work_thread;
 
     std::unordered_set<Connection*> _connections;
+
+    // Slots for connections, used by IO thread only
+    ObjectPool<Connection> _connection_pool;
+
+    // IO blocks lent to connections while data is in flight, used by IO thread only
+    ChunkPool _chunk_pool;
+
+    // Backpressure counters of all connections
+    BackpressureStats _stats;
+
+    // Work connection could do per wakeup, see Budget.h
+    Budget _budget;
+
+    // Milliseconds connections have to send queued responses after Stop
+    uint32_t _drain_timeout;
+
+    // Connections to be served on the next iteration regardless of epoll, and those being served on
+    // the current one. Closed connection is replaced by nullptr
+    std::vector<Connection *> _ready;
+    std::vector<Connection *> _serving;
 };
 
 } // namespace STnonblock
@@ -0,0 +1,73 @@
+#include "Connection.h"
+
+#include <algorithm>
+
+#include <spdlog/logger.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// See Connection.h
+Connection::Connection(int s, std::shared_ptr<spdlog::logger> l, std::shared_ptr<Afina::Storage> stg)
+    : _socket(s), _logger(l), pStorage(stg), arg_remains(0), _sent(0), _recv_armed(false), _reading(true),
+      _send_inflight(false), _dirty(false) {}
+
+// See Connection.h
+void Connection::Consume(const char *data, std::size_t size) {
+    // Single block of data received from the socket could trigger inside actions a multiple times,
+    // for example:
+    // - recv#0: [<command1 start>]
+    // - recv#1: [<command1 end> <argument> <command2> <argument for command 2> <command3> ... ]
+    while (size > 0) {
+        _logger->debug("Process {} bytes", size);
+        // There is no command yet
+        if (!command_to_execute) {
+            std::size_t parsed = 0;
+            if (parser.Parse(data, size, parsed)) {
+                // Here we are, current chunk finished some command, process it
+                _logger->debug("Found new command: {} in {} bytes", parser.Name(), parsed);
+                command_to_execute = parser.BuildInPlace(arg_remains);
+                arg_remains = parser.BlockSize();
+            }
+
+            // Parsed might fails to consume any bytes from input stream
+            if (parsed == 0) {
+                break;
+            }
+            data += parsed;
+            size -= parsed;
+        }
+
+        // There is command, but we still wait for argument to arrive...
+        if (command_to_execute && arg_remains > 0) {
+            _logger->debug("Fill argument: {} bytes of {}", size, arg_remains);
+            std::size_t to_read = std::min(arg_remains, size);
+            argument_for_command.append(data, to_read);
+            arg_remains -= to_read;
+            data += to_read;
+            size -= to_read;
+        }
+
+        // Thre is command & argument - RUN!
+        if (command_to_execute && arg_remains == 0) {
+            _logger->debug("Start command execution");
+
+            parser.StripBlock(argument_for_command);
+
+            result_of_command.clear();
+            command_to_execute->Execute(*pStorage, argument_for_command, result_of_command);
+            _output += result_of_command;
+            _output += "\r\n";
+
+            // Prepare for the next command
+            command_to_execute.reset();
+            argument_for_command.resize(0);
+            parser.Reset();
+        }
+    }
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
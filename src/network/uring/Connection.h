@@ -0,0 +1,70 @@
+#ifndef AFINA_NETWORK_URING_CONNECTION_H
+#define AFINA_NETWORK_URING_CONNECTION_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/logging/Service.h>
+#include <protocol/Parser.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # Client connection
+ * Protocol state of the single client. Connection never touches socket itself, worker feeds it with received
+ * bytes and sends responses it has accumulated
+ */
+class Connection {
+public:
+    Connection(int s, std::shared_ptr<spdlog::logger> l, std::shared_ptr<Afina::Storage> stg);
+
+    /**
+     * Parses given bytes, executes every completed command and queues its response. Throws
+     * std::runtime_error if client breaks the protocol
+     */
+    void Consume(const char *data, std::size_t size);
+
+private:
+    friend class Worker;
+
+    int _socket;
+    std::shared_ptr<spdlog::logger> _logger;
+    std::shared_ptr<Afina::Storage> pStorage;
+
+    Protocol::InPlaceCommand command_to_execute;
+    Protocol::Parser parser;
+    std::size_t arg_remains;
+    std::string argument_for_command;
+    // Reused by all commands of the connection to keep its capacity
+    std::string result_of_command;
+
+    // Responses not yet given to kernel
+    std::string _output;
+
+    // Responses kernel is sending now, must stay untouched until send completes
+    std::string _sending;
+    std::size_t _sent;
+
+    // Multishot receive is armed in the ring
+    bool _recv_armed;
+
+    // Client might send more commands
+    bool _reading;
+
+    // Send operation is in the ring
+    bool _send_inflight;
+
+    // Connection is in the list of ones with output to flush
+    bool _dirty;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_CONNECTION_H
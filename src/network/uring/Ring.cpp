@@ -0,0 +1,238 @@
+#include "Ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+namespace {
+
+inline int io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+inline int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+inline int io_uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+template <typename T> inline T *at(void *base, std::size_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+} // namespace
+
+// See Ring.h
+Ring::Ring(unsigned entries, unsigned buffers, std::size_t buffer_size)
+    : _fd(-1), _sq_ptr(MAP_FAILED), _sqes(static_cast<struct io_uring_sqe *>(MAP_FAILED)), _sq_local_tail(0),
+      _sq_submitted(0), _cq_ptr(MAP_FAILED), _buf_ring(static_cast<struct io_uring_buf_ring *>(MAP_FAILED)),
+      _buffers(nullptr), _buffer_size(buffer_size) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * kCqFactor;
+
+    _fd = io_uring_setup(entries, &params);
+    if (_fd == -1 && errno == EINVAL) {
+        // Older kernels don't know about cooperative task running
+        params.flags &= ~IORING_SETUP_COOP_TASKRUN;
+        _fd = io_uring_setup(entries, &params);
+    }
+    if (_fd == -1) {
+        throw std::runtime_error("Failed to setup io_uring: " + std::string(strerror(errno)));
+    }
+
+    _sq_entries = params.sq_entries;
+    _sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        _sq_size = _cq_size = std::max(_sq_size, _cq_size);
+    }
+
+    _sq_ptr = mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    if (_sq_ptr == MAP_FAILED) {
+        int err = errno;
+        release();
+        throw std::runtime_error("Failed to map io_uring: " + std::string(strerror(err)));
+    }
+
+    if (single_mmap) {
+        _cq_ptr = _sq_ptr;
+    } else {
+        _cq_ptr = mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+        if (_cq_ptr == MAP_FAILED) {
+            int err = errno;
+            release();
+            throw std::runtime_error("Failed to map io_uring: " + std::string(strerror(err)));
+        }
+    }
+
+    _sqes = static_cast<struct io_uring_sqe *>(mmap(nullptr, _sq_entries * sizeof(struct io_uring_sqe),
+                                                    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                                                    IORING_OFF_SQES));
+    if (_sqes == MAP_FAILED) {
+        int err = errno;
+        release();
+        throw std::runtime_error("Failed to map io_uring: " + std::string(strerror(err)));
+    }
+
+    _sq_head = at<unsigned>(_sq_ptr, params.sq_off.head);
+    _sq_tail = at<unsigned>(_sq_ptr, params.sq_off.tail);
+    _sq_mask = at<unsigned>(_sq_ptr, params.sq_off.ring_mask);
+    _sq_array = at<unsigned>(_sq_ptr, params.sq_off.array);
+    _sq_local_tail = _sq_submitted = *_sq_tail;
+
+    _cq_head = at<unsigned>(_cq_ptr, params.cq_off.head);
+    _cq_tail = at<unsigned>(_cq_ptr, params.cq_off.tail);
+    _cq_mask = at<unsigned>(_cq_ptr, params.cq_off.ring_mask);
+    _cqes = at<struct io_uring_cqe>(_cq_ptr, params.cq_off.cqes);
+
+    try {
+        setup_buffers(buffers);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+// See Ring.h
+Ring::~Ring() { release(); }
+
+void Ring::release() {
+    if (_buf_ring != MAP_FAILED) {
+        munmap(_buf_ring, _buf_ring_size);
+        _buf_ring = static_cast<struct io_uring_buf_ring *>(MAP_FAILED);
+    }
+    delete[] _buffers;
+    _buffers = nullptr;
+
+    if (_sqes != MAP_FAILED) {
+        munmap(_sqes, _sq_entries * sizeof(struct io_uring_sqe));
+        _sqes = static_cast<struct io_uring_sqe *>(MAP_FAILED);
+    }
+    if (_cq_ptr != MAP_FAILED && _cq_ptr != _sq_ptr) {
+        munmap(_cq_ptr, _cq_size);
+    }
+    _cq_ptr = MAP_FAILED;
+    if (_sq_ptr != MAP_FAILED) {
+        munmap(_sq_ptr, _sq_size);
+        _sq_ptr = MAP_FAILED;
+    }
+
+    if (_fd != -1) {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+// See Ring.h
+struct io_uring_sqe *Ring::get_sqe() {
+    unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    if (_sq_local_tail - head >= _sq_entries) {
+        submit();
+        head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+        if (_sq_local_tail - head >= _sq_entries) {
+            throw std::runtime_error("io_uring submission queue is full");
+        }
+    }
+
+    unsigned index = _sq_local_tail & *_sq_mask;
+    _sq_array[index] = index;
+    _sq_local_tail++;
+
+    struct io_uring_sqe *sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+// See Ring.h
+void Ring::submit(unsigned wait_nr) {
+    __atomic_store_n(_sq_tail, _sq_local_tail, __ATOMIC_RELEASE);
+
+    unsigned to_submit = _sq_local_tail - _sq_submitted;
+    if (to_submit == 0 && wait_nr == 0) {
+        return;
+    }
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int submitted;
+    while ((submitted = io_uring_enter(_fd, to_submit, wait_nr, flags)) == -1) {
+        // EINTR: interrupted by signal while waiting, EBUSY/EAGAIN: completion queue must be drained first.
+        // Either way caller has got something to do
+        if (errno == EINTR || errno == EBUSY || errno == EAGAIN) {
+            return;
+        }
+        throw std::runtime_error("Failed to submit to io_uring: " + std::string(strerror(errno)));
+    }
+    _sq_submitted += submitted;
+}
+
+// See Ring.h
+struct io_uring_cqe *Ring::peek_cqe() {
+    unsigned head = *_cq_head;
+    if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)) {
+        return nullptr;
+    }
+    return &_cqes[head & *_cq_mask];
+}
+
+// See Ring.h
+void Ring::cqe_seen() { __atomic_store_n(_cq_head, *_cq_head + 1, __ATOMIC_RELEASE); }
+
+// See Ring.h
+void Ring::recycle_buffer(uint16_t bid) {
+    // Don't use _buf_ring->bufs: in C++ flexible array declared by kernel header is shifted by an empty
+    // struct of non zero size, while ring is just an array of io_uring_buf with tail overlaying first one
+    uint16_t tail = _buf_ring->tail;
+    struct io_uring_buf *buf = reinterpret_cast<struct io_uring_buf *>(_buf_ring) + (tail & (_buf_entries - 1));
+    buf->addr = reinterpret_cast<uint64_t>(buffer(bid));
+    buf->len = _buffer_size;
+    buf->bid = bid;
+    __atomic_store_n(&_buf_ring->tail, uint16_t(tail + 1), __ATOMIC_RELEASE);
+}
+
+void Ring::setup_buffers(unsigned buffers) {
+    if (buffers == 0 || (buffers & (buffers - 1)) != 0 || buffers > 32768) {
+        throw std::runtime_error("Number of provided buffers must be power of 2 not above 32768");
+    }
+
+    _buf_entries = buffers;
+    _buf_ring_size = buffers * sizeof(struct io_uring_buf);
+    _buf_ring = static_cast<struct io_uring_buf_ring *>(
+        mmap(nullptr, _buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (_buf_ring == MAP_FAILED) {
+        throw std::runtime_error("Failed to allocate buffer ring: " + std::string(strerror(errno)));
+    }
+
+    struct io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(_buf_ring);
+    reg.ring_entries = buffers;
+    reg.bgid = kBufferGroup;
+    if (io_uring_register(_fd, IORING_REGISTER_PBUF_RING, &reg, 1) == -1) {
+        throw std::runtime_error("Failed to register buffer ring: " + std::string(strerror(errno)));
+    }
+
+    _buffers = new char[buffers * _buffer_size];
+    _buf_ring->tail = 0;
+    for (unsigned i = 0; i < buffers; i++) {
+        recycle_buffer(i);
+    }
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
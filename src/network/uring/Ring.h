@@ -0,0 +1,107 @@
+#ifndef AFINA_NETWORK_URING_RING_H
+#define AFINA_NETWORK_URING_RING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+/**
+ * # io_uring instance
+ * Thin wrapper over raw io_uring syscalls: maps submission and completion queues into process memory
+ * and registers ring of provided buffers that multishot receives take their buffers from.
+ *
+ * Submission entries are only queued by get_sqe(), nothing goes to kernel until submit() so that whole
+ * batch costs single syscall. Not threadsafe, must be used from one thread
+ */
+class Ring {
+public:
+    /**
+     * @param entries size of the submission queue, completion queue is kCqFactor times bigger
+     * @param buffers number of provided buffers, must be power of 2
+     * @param buffer_size size of each provided buffer
+     */
+    Ring(unsigned entries, unsigned buffers, std::size_t buffer_size);
+    ~Ring();
+
+    /**
+     * Returns zeroed submission entry to fill in. If queue is full then already queued entries
+     * are submitted first
+     */
+    struct io_uring_sqe *get_sqe();
+
+    /**
+     * Submits all queued entries and waits until at least wait_nr completions are available
+     */
+    void submit(unsigned wait_nr = 0);
+
+    /**
+     * Returns oldest completion not seen yet, or nullptr if there is no one
+     */
+    struct io_uring_cqe *peek_cqe();
+
+    /**
+     * Marks completion returned by peek_cqe() as consumed, its slot could be reused by kernel
+     */
+    void cqe_seen();
+
+    /**
+     * Group provided buffers are registered in, should be set in sqe->buf_group
+     */
+    uint16_t buffer_group() const { return kBufferGroup; }
+
+    /**
+     * Provided buffer with given id
+     */
+    char *buffer(uint16_t bid) const { return _buffers + std::size_t(bid) * _buffer_size; }
+
+    /**
+     * Gives buffer back to kernel once its content is consumed
+     */
+    void recycle_buffer(uint16_t bid);
+
+private:
+    Ring(const Ring &) = delete;
+    Ring &operator=(const Ring &) = delete;
+
+    static const unsigned kCqFactor = 4;
+    static const uint16_t kBufferGroup = 0;
+
+    void setup_buffers(unsigned buffers);
+    void release();
+
+    int _fd;
+
+    // Submission queue
+    void *_sq_ptr;
+    std::size_t _sq_size;
+    unsigned *_sq_head, *_sq_tail, *_sq_mask, *_sq_array;
+    unsigned _sq_entries;
+    struct io_uring_sqe *_sqes;
+
+    // Entries given by get_sqe() but not submitted yet
+    unsigned _sq_local_tail, _sq_submitted;
+
+    // Completion queue, might share mapping with submission one
+    void *_cq_ptr;
+    std::size_t _cq_size;
+    unsigned *_cq_head, *_cq_tail, *_cq_mask;
+    struct io_uring_cqe *_cqes;
+
+    // Provided buffers
+    struct io_uring_buf_ring *_buf_ring;
+    std::size_t _buf_ring_size;
+    unsigned _buf_entries;
+    char *_buffers;
+    std::size_t _buffer_size;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_URING_RING_H
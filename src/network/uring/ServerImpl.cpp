@@ -0,0 +1,124 @@
+#include "ServerImpl.h"
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/Storage.h>
+#include <afina/logging/Service.h>
+#include <network/common/Tuning.h>
+
+#include "Worker.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+// See Server.h
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Logging::Service> pl)
+    : Server(ps, pl), _server_socket(-1) {}
+
+// See Server.h
+ServerImpl::~ServerImpl() {}
+
+// See Server.h
+void ServerImpl::Start(const Options &options) {
+    _logger = pLogging->select("network");
+    _logger->info("Start uring network service");
+
+    sigset_t sig_mask;
+    sigemptyset(&sig_mask);
+    sigaddset(&sig_mask, SIGPIPE);
+    if (pthread_sigmask(SIG_BLOCK, &sig_mask, NULL) != 0) {
+        throw std::runtime_error("Unable to mask SIGPIPE");
+    }
+
+    // Create server socket
+    struct sockaddr_in server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;           // IPv4
+    server_addr.sin_port = htons(options.port); // TCP port number
+    server_addr.sin_addr.s_addr = INADDR_ANY;   // Bind to any address
+
+    _server_socket = socket(PF_INET, SOCK_STREAM | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (_server_socket == -1) {
+        throw std::runtime_error("Failed to open socket: " + std::string(strerror(errno)));
+    }
+
+    int opts = 1;
+    if (setsockopt(_server_socket, SOL_SOCKET, SO_REUSEADDR, &opts, sizeof(opts)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket setsockopt() failed: " + std::string(strerror(errno)));
+    }
+
+    if (bind(_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket bind() failed: " + std::string(strerror(errno)));
+    }
+
+    TuneListening(_server_socket, options);
+
+    if (listen(_server_socket, options.backlog) == -1) {
+        close(_server_socket);
+        throw std::runtime_error("Socket listen() failed: " + std::string(strerror(errno)));
+    }
+
+    // Every worker accepts by itself, there is nothing for acceptors to do
+    _logger->debug("Ignore {} acceptors, connections are accepted by {} workers", options.acceptors,
+                   options.workers);
+
+    _workers.reserve(options.workers);
+    std::size_t started = 0;
+    try {
+        for (uint32_t i = 0; i < options.workers; i++) {
+            _workers.emplace_back(pStorage, pLogging);
+            _workers.back().Start(_server_socket);
+            started++;
+        }
+    } catch (...) {
+        // Threads of workers started so far run on the server's objects, they must be gone before it fails
+        _workers.erase(_workers.begin() + started, _workers.end());
+        for (auto &w : _workers) {
+            w.Stop();
+        }
+        for (auto &w : _workers) {
+            w.Join();
+        }
+        _workers.clear();
+
+        close(_server_socket);
+        _server_socket = -1;
+        throw;
+    }
+}
+
+// See Server.h
+void ServerImpl::Stop() {
+    _logger->warn("Stop network service");
+    for (auto &w : _workers) {
+        w.Stop();
+    }
+}
+
+// See Server.h
+void ServerImpl::Join() {
+    for (auto &w : _workers) {
+        w.Join();
+    }
+    _workers.clear();
+
+    close(_server_socket);
+    _server_socket = -1;
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,335 @@
+#include "Worker.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <spdlog/logger.h>
+
+#include <afina/logging/Service.h>
+
+#include "Connection.h"
+#include "Ring.h"
+
+namespace Afina {
+namespace Network {
+namespace Uring {
+
+namespace {
+
+// Ring geometry: submissions per batch, provided buffers count and size
+const unsigned kRingEntries = 256;
+const unsigned kBuffers = 512;
+const std::size_t kBufferSize = 4096;
+
+} // namespace
+
+// See Worker.h
+Worker::Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl)
+    : _pStorage(ps), _pLogging(pl), _server_socket(-1), _event_fd(-1), _event_value(0), _accepting(false),
+      _stopping(false) {}
+
+// See Worker.h
+Worker::~Worker() {
+    if (_event_fd != -1) {
+        close(_event_fd);
+    }
+}
+
+// See Worker.h
+Worker::Worker(Worker &&other) : _event_fd(-1) { *this = std::move(other); }
+
+// See Worker.h
+Worker &Worker::operator=(Worker &&other) {
+    _pStorage = std::move(other._pStorage);
+    _pLogging = std::move(other._pLogging);
+    _logger = std::move(other._logger);
+    _thread = std::move(other._thread);
+    _ring = std::move(other._ring);
+    _server_socket = other._server_socket;
+    _event_fd = other._event_fd;
+    _event_value = other._event_value;
+    _accepting = other._accepting;
+    _stopping = other._stopping;
+    _connections = std::move(other._connections);
+    _dirty = std::move(other._dirty);
+
+    other._event_fd = -1;
+    return *this;
+}
+
+// See Worker.h
+void Worker::Start(int server_socket) {
+    assert(!_ring);
+    _logger = _pLogging->select("network.worker");
+    _server_socket = server_socket;
+    _ring.reset(new Ring(kRingEntries, kBuffers, kBufferSize));
+
+    _event_fd = eventfd(0, EFD_CLOEXEC);
+    if (_event_fd == -1) {
+        throw std::runtime_error("Failed to create event descriptor: " + std::string(strerror(errno)));
+    }
+    _thread = std::thread(&Worker::OnRun, this);
+}
+
+// See Worker.h
+void Worker::Stop() {
+    if (eventfd_write(_event_fd, 1)) {
+        throw std::runtime_error("Failed to wakeup worker");
+    }
+}
+
+// See Worker.h
+void Worker::Join() {
+    assert(_thread.joinable());
+    _thread.join();
+}
+
+// See Worker.h
+void Worker::OnRun() {
+    _logger->trace("OnRun");
+    ArmAccept();
+    ArmWakeup();
+
+    while (_accepting || !_connections.empty()) {
+        // Single syscall submits everything queued during previous round and waits for new completions
+        _ring->submit(1);
+
+        struct io_uring_cqe *pcqe;
+        while ((pcqe = _ring->peek_cqe()) != nullptr) {
+            struct io_uring_cqe cqe = *pcqe;
+            _ring->cqe_seen();
+
+            Connection *pconn = reinterpret_cast<Connection *>(cqe.user_data & ~uint64_t(kMask));
+            switch (cqe.user_data & kMask) {
+            case kAccept:
+                OnAccept(cqe);
+                break;
+            case kRecv:
+                OnRecv(pconn, cqe);
+                break;
+            case kSend:
+                OnSend(pconn, cqe);
+                break;
+            case kWakeup:
+                OnWakeup();
+                break;
+            default:
+                break;
+            }
+        }
+
+        Flush();
+    }
+
+    _logger->warn("Worker stopped");
+}
+
+void Worker::OnAccept(const struct io_uring_cqe &cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        _accepting = false;
+        if (!_stopping) {
+            _logger->debug("Accept got disarmed: {}", strerror(-cqe.res));
+            ArmAccept();
+        }
+    }
+
+    if (cqe.res < 0) {
+        if (cqe.res != -ECANCELED) {
+            _logger->error("Failed to accept socket: {}", strerror(-cqe.res));
+        }
+        return;
+    }
+
+    if (_stopping) {
+        close(cqe.res);
+        return;
+    }
+
+    _logger->debug("Accepted connection on descriptor {}", cqe.res);
+    Connection *pconn = new Connection(cqe.res, _logger, _pStorage);
+    _connections.insert(pconn);
+    ArmRecv(pconn);
+}
+
+void Worker::OnRecv(Connection *pconn, const struct io_uring_cqe &cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        pconn->_recv_armed = false;
+    }
+
+    if (cqe.res > 0) {
+        assert(cqe.flags & IORING_CQE_F_BUFFER);
+        uint16_t bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        try {
+            if (pconn->_reading) {
+                pconn->Consume(_ring->buffer(bid), cqe.res);
+            }
+        } catch (std::runtime_error &ex) {
+            _logger->error("Failed to process connection on descriptor {}: {}", pconn->_socket, ex.what());
+            Shutdown(pconn);
+        }
+        _ring->recycle_buffer(bid);
+
+        if (!pconn->_output.empty() && !pconn->_dirty) {
+            pconn->_dirty = true;
+            _dirty.push_back(pconn);
+        }
+    } else if (cqe.res == 0) {
+        _logger->debug("Connection on descriptor {} closed by client", pconn->_socket);
+        pconn->_reading = false;
+    } else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+        _logger->error("Failed to read from connection on descriptor {}: {}", pconn->_socket, strerror(-cqe.res));
+        pconn->_reading = false;
+    }
+
+    // Provided buffers ran out, they are recycled already so receive could go on
+    if (!pconn->_recv_armed && pconn->_reading) {
+        ArmRecv(pconn);
+    }
+    CloseIfDone(pconn);
+}
+
+void Worker::OnSend(Connection *pconn, const struct io_uring_cqe &cqe) {
+    pconn->_send_inflight = false;
+    if (cqe.res < 0) {
+        _logger->error("Failed to write to connection on descriptor {}: {}", pconn->_socket, strerror(-cqe.res));
+        pconn->_output.clear();
+        pconn->_sending.clear();
+        Shutdown(pconn);
+        CloseIfDone(pconn);
+        return;
+    }
+
+    pconn->_sent += cqe.res;
+    if (pconn->_sent < pconn->_sending.size()) {
+        Send(pconn);
+        return;
+    }
+
+    pconn->_sending.clear();
+    pconn->_sent = 0;
+    if (!pconn->_output.empty()) {
+        Send(pconn);
+    }
+    CloseIfDone(pconn);
+}
+
+void Worker::OnWakeup() {
+    _logger->debug("Stop signal received");
+    _stopping = true;
+    if (_accepting) {
+        Cancel(kAccept);
+    }
+
+    for (Connection *pconn : _connections) {
+        Shutdown(pconn);
+    }
+
+    // Connections might be closed right away, so iterate over copy
+    std::vector<Connection *> connections(_connections.begin(), _connections.end());
+    for (Connection *pconn : connections) {
+        CloseIfDone(pconn);
+    }
+}
+
+void Worker::ArmAccept() {
+    struct io_uring_sqe *sqe = _ring->get_sqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _server_socket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = kAccept;
+    _accepting = true;
+}
+
+void Worker::ArmRecv(Connection *pconn) {
+    struct io_uring_sqe *sqe = _ring->get_sqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = pconn->_socket;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = _ring->buffer_group();
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = reinterpret_cast<uint64_t>(pconn) | kRecv;
+    pconn->_recv_armed = true;
+}
+
+void Worker::ArmWakeup() {
+    struct io_uring_sqe *sqe = _ring->get_sqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = _event_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&_event_value);
+    sqe->len = sizeof(_event_value);
+    sqe->user_data = kWakeup;
+}
+
+void Worker::Cancel(uint64_t user_data) {
+    struct io_uring_sqe *sqe = _ring->get_sqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = user_data;
+    sqe->user_data = kCancel;
+}
+
+void Worker::Flush() {
+    for (Connection *pconn : _dirty) {
+        if (pconn == nullptr) {
+            continue;
+        }
+        pconn->_dirty = false;
+        if (!pconn->_send_inflight && !pconn->_output.empty()) {
+            Send(pconn);
+        }
+    }
+    _dirty.clear();
+}
+
+void Worker::Send(Connection *pconn) {
+    assert(!pconn->_send_inflight);
+    if (pconn->_sending.empty()) {
+        pconn->_sending.swap(pconn->_output);
+        pconn->_sent = 0;
+    }
+
+    struct io_uring_sqe *sqe = _ring->get_sqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = pconn->_socket;
+    sqe->addr = reinterpret_cast<uint64_t>(pconn->_sending.data() + pconn->_sent);
+    sqe->len = pconn->_sending.size() - pconn->_sent;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = reinterpret_cast<uint64_t>(pconn) | kSend;
+    pconn->_send_inflight = true;
+}
+
+void Worker::Shutdown(Connection *pconn) {
+    pconn->_reading = false;
+    if (pconn->_recv_armed) {
+        Cancel(reinterpret_cast<uint64_t>(pconn) | kRecv);
+    }
+}
+
+void Worker::CloseIfDone(Connection *pconn) {
+    if (pconn->_reading || pconn->_recv_armed || pconn->_send_inflight || !pconn->_output.empty()) {
+        return;
+    }
+
+    _logger->debug("Close connection on descriptor {}", pconn->_socket);
+    close(pconn->_socket);
+    _connections.erase(pconn);
+    if (pconn->_dirty) {
+        for (auto &dirty : _dirty) {
+            if (dirty == pconn) {
+                dirty = nullptr;
+            }
+        }
+    }
+    delete pconn;
+}
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
@@ -0,0 +1,128 @@
+#ifndef AFINA_NETWORK_URING_WORKER_H
+#define AFINA_NETWORK_URING_WORKER_H
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <linux/io_uring.h>
+
+namespace spdlog {
+class logger;
+}
+
+namespace Afina {
+
+// Forward declaration, see afina/Storage.h
+class Storage;
+namespace Logging {
+class Service;
+}
+
+namespace Network {
+namespace Uring {
+
+class Connection;
+class Ring;
+
+/**
+ * # Thread running io_uring
+ * Each worker owns its ring and all connections it has accepted. Ring keeps multishot accept on the
+ * server socket and multishot receive on each connection armed, so they produce completions without
+ * any resubmission. Responses are collected while completions are processed and all the sends go to
+ * kernel in a single batch together with waiting for the next completions
+ */
+class Worker {
+public:
+    Worker(std::shared_ptr<Afina::Storage> ps, std::shared_ptr<Afina::Logging::Service> pl);
+    ~Worker();
+
+    Worker(Worker &&);
+    Worker &operator=(Worker &&);
+
+    /**
+     * Creates ring and spawns background thread accepting connections on the given server socket.
+     * Throws std::runtime_error if io_uring is unavailable
+     */
+    void Start(int server_socket);
+
+    /**
+     * Signal background thread to stop. Thread stops accepting connections and receiving commands, once
+     * responses for the received ones are sent it closes connections and exits
+     */
+    void Stop();
+
+    /**
+     * Blocks calling thread until background one for this worker is actually
+     * been destoryed
+     */
+    void Join();
+
+protected:
+    /**
+     * Method executing by background thread
+     */
+    void OnRun();
+
+private:
+    Worker(Worker &) = delete;
+    Worker &operator=(Worker &) = delete;
+
+    // Operation kind is kept in the lowest bits of user_data, the rest is the connection address
+    enum Op : uint64_t { kAccept = 1, kRecv = 2, kSend = 3, kWakeup = 4, kCancel = 5, kMask = 7 };
+
+    void OnAccept(const struct io_uring_cqe &cqe);
+    void OnRecv(Connection *pconn, const struct io_uring_cqe &cqe);
+    void OnSend(Connection *pconn, const struct io_uring_cqe &cqe);
+    void OnWakeup();
+
+    void ArmAccept();
+    void ArmRecv(Connection *pconn);
+    void ArmWakeup();
+    void Cancel(uint64_t user_data);
+
+    // Queues send of the pending output of all connections in _dirty
+    void Flush();
+    void Send(Connection *pconn);
+
+    // Stops reading from connection, it will be closed once nothing is in flight
+    void Shutdown(Connection *pconn);
+    void CloseIfDone(Connection *pconn);
+
+    // afina services
+    std::shared_ptr<Afina::Storage> _pStorage;
+
+    // afina services
+    std::shared_ptr<Afina::Logging::Service> _pLogging;
+
+    // Logger to be used
+    std::shared_ptr<spdlog::logger> _logger;
+
+    // Thread serving requests in this worker
+    std::thread _thread;
+
+    std::unique_ptr<Ring> _ring;
+
+    int _server_socket;
+
+    // Written by Stop() to wakeup thread waiting on the ring
+    int _event_fd;
+    uint64_t _event_value;
+
+    // Accept is armed in the ring
+    bool _accepting;
+
+    bool _stopping;
+
+    std::unordered_set<Connection *> _connections;
+
+    // Connections got new responses during current batch of completions
+    std::vector<Connection *> _dirty;
+};
+
+} // namespace Uring
+} // namespace Network
+} // namespace Afina
+#endif // AFINA_NETWORK_URING_WORKER_H
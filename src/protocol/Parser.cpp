@@ -1,6 +1,7 @@
 #include "Parser.h"
 
 #include <iostream>
+#include <new>
 #include <sstream>
 #include <stdexcept>
 
@@ -47,7 +48,7 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::spKey: {
             if (c == ' ') {
                 state = State::spFlags;
-                keys.push_back(curKey);
+                add_key();
                 // std::cout << "parser debug: key[" << keys.size() - 1 << "]='" << curKey << "'" << std::endl;
             } else {
                 curKey.push_back(c);
@@ -57,10 +58,10 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
 
         case State::sgKey: {
             if (c == '\r') {
-                keys.push_back(curKey);
-                // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
+                add_key();
+                // std::cout << "parser debug: total '" << nkeys << " keys" << std::endl;
 
-                if (keys.size() == 0) {
+                if (nkeys == 0) {
                     throw std::runtime_error("Client provides no key to retrive");
                 }
 
@@ -69,7 +70,7 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             } else if (c == ' ') {
                 // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
                 state = State::sgKey;
-                keys.push_back(curKey);
+                add_key();
                 curKey.clear();
             } else {
                 curKey.push_back(c);
@@ -161,33 +162,85 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
     return parse_complete;
 }
 
+namespace {
+
+template <typename T, typename... Args> T *construct(void *place, Args &&... args) {
+    static_assert(sizeof(T) <= Parser::kCommandSize && alignof(T) <= alignof(void *), "Command doesn't fit parser");
+    if (place == nullptr) {
+        return new T(std::forward<Args>(args)...);
+    }
+    return new (place) T(std::forward<Args>(args)...);
+}
+
+} // namespace
+
+// See Parse.h
+void InPlaceDeleter::operator()(Execute::Command *cmd) const { cmd->~Command(); }
+
 // See Parse.h
 std::unique_ptr<Execute::Command> Parser::Build(size_t &body_size) const {
+    return std::unique_ptr<Execute::Command>(make_command(body_size, nullptr));
+}
+
+// See Parse.h
+InPlaceCommand Parser::BuildInPlace(size_t &body_size) { return InPlaceCommand(make_command(body_size, command)); }
+
+// See Parse.h
+std::size_t Parser::BlockSize() const {
+    if (state != State::sLF || !(name == "set" || name == "add" || name == "append" || name == "prepend")) {
+        return 0;
+    }
+    return std::size_t(bytes) + 2;
+}
+
+// See Parse.h
+void Parser::StripBlock(std::string &block) const {
+    std::size_t size = BlockSize();
+    if (size == 0) {
+        return;
+    }
+
+    if (block.size() != size || block.compare(bytes, 2, "\r\n") != 0) {
+        throw std::runtime_error("bad data chunk");
+    }
+    block.resize(bytes);
+}
+
+Execute::Command *Parser::make_command(size_t &body_size, void *place) const {
     if (state != State::sLF) {
-        return std::unique_ptr<Execute::Command>(nullptr);
+        return nullptr;
     }
 
     body_size = bytes;
     if (name == "set") {
-        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
+        return construct<Execute::Set>(place, keys[0], flags, exprtime);
     } else if (name == "add") {
-        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
+        return construct<Execute::Add>(place, keys[0], flags, exprtime);
     } else if (name == "append") {
-        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
+        return construct<Execute::Append>(place, keys[0], flags, exprtime);
     } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
+        return construct<Execute::Get>(place, keys.data(), keys.data() + nkeys);
     } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
+        return construct<Execute::Stats>(place);
     } else {
         throw std::runtime_error("Unsupported command");
     }
 }
 
+void Parser::add_key() {
+    if (nkeys < keys.size()) {
+        keys[nkeys].assign(curKey);
+    } else {
+        keys.push_back(curKey);
+    }
+    nkeys++;
+}
+
 // See Parse.h
 void Parser::Reset() {
     state = State::sName;
     name.clear();
-    keys.clear();
+    nkeys = 0;
     curKey.clear();
     parse_complete = false;
     flags = 0;
@@ -14,13 +14,31 @@ class Command;
 } // namespace Execute
 namespace Protocol {
 
+/**
+ * Deleter for commands built inside of the parser: only destroys object, its memory belongs
+ * to the parser
+ */
+struct InPlaceDeleter {
+    void operator()(Execute::Command *cmd) const;
+};
+
+using InPlaceCommand = std::unique_ptr<Execute::Command, InPlaceDeleter>;
+
 /**
  * # Memcached protocol parser
  * Parser supports subset of memcached protocol
  */
 class Parser {
 public:
+    // Bytes reserved for the command built in place, any of them fits
+    static constexpr std::size_t kCommandSize = 32;
+
     Parser() { Reset(); }
+
+    // Command built in place lives inside of parser, it can't go anywhere
+    Parser(const Parser &) = delete;
+    Parser &operator=(const Parser &) = delete;
+
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
      * from comulative input. In a such case method Build will return new command
@@ -44,10 +62,32 @@ public:
 
     /**
      * Builds new command from parsed input. In case if it wasn't enough input to prse command out
-     * method return nullptr
+     * method return nullptr. Command refers to the keys parsed out, so it must be executed before
+     * parser gets reset
      */
     std::unique_ptr<Execute::Command> Build(size_t &body_size) const;
 
+    /**
+     * Same as above, but command is placed into the parser itself instead of heap, so that it costs
+     * nothing to allocate and release it. There is room for a single command only: previous one must
+     * be destroyed before the next one is built
+     */
+    InPlaceCommand BuildInPlace(size_t &body_size);
+
+    /**
+     * Number of bytes following the command line which belong to the parsed command: data block together
+     * with its \r\n terminator, even if block is empty. 0 if command has no data block
+     */
+    std::size_t BlockSize() const;
+
+    /**
+     * Checks that data block read as BlockSize() bytes is terminated by \r\n and strips the terminator, so
+     * that only the value is left. Throws std::runtime_error if it isn't terminated properly
+     *
+     * @param block data block of the parsed command
+     */
+    void StripBlock(std::string &block) const;
+
     /**
      * Reset parse so that it could be used to parse out new command
      */
@@ -56,6 +96,16 @@ public:
     inline const std::string &Name() const { return name; }
 
 private:
+    /**
+     * Creates command out of parsed input either at the given place or, if it is null, on heap
+     */
+    Execute::Command *make_command(size_t &body_size, void *place) const;
+
+    /**
+     * Appends curKey to the keys of the current command
+     */
+    void add_key();
+
     /**
      * State of the command parser. Prefixes are:
      * - s: state for PUT and GET commands
@@ -67,9 +117,11 @@ private:
     // Current parser state
     State state;
 
-    // vrious fields of the command
+    // vrious fields of the command. Only first nkeys of keys belong to the current command, the rest are
+    // left by previous ones so that their strings keep capacity
     std::string name;
     std::vector<std::string> keys;
+    std::size_t nkeys;
 
     // <flags> is an arbitrary 16-bit unsigned integer (written out in decimal) that the server stores along with
     // the data and sends back when the item is retrieved. Clients may use this as a bit field to store data-specific
@@ -91,6 +143,9 @@ private:
     bool negative;
     std::string curKey;
     bool parse_complete;
+
+    // Room for the command built in place
+    alignas(void *) unsigned char command[kCommandSize];
 };
 
 } // namespace Protocol
@@ -1,11 +1,52 @@
 #include "SimpleLRU.h"
 
+#include <algorithm>
+#include <fstream>
+
+#include <malloc.h>
+#include <unistd.h>
+
 namespace Afina {
 namespace Backend {
 
+namespace {
+
+// How often process RSS is checked
+const size_t kRssCheckInterval = 1024;
+
+// Strings up to this size are stored inside of the object itself
+const size_t kInlineCapacity = std::string().capacity();
+
+// Size of the chunk malloc gives for request of n bytes: one word of header, rounded up to
+// two words, never less than four words
+inline size_t malloc_size(size_t n) {
+    const size_t align = 2 * sizeof(void *);
+    return std::max(4 * sizeof(void *), (n + sizeof(void *) + align - 1) & ~(align - 1));
+}
+
+// Heap memory owned by string of given capacity
+inline size_t string_memory(size_t capacity) { return capacity > kInlineCapacity ? malloc_size(capacity + 1) : 0; }
+
+// Process RSS in bytes, 0 if unknown
+size_t current_rss() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total = 0, resident = 0;
+    if (!(statm >> total >> resident)) {
+        return 0;
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+} // namespace
+
+// See SimpleLRU.h
+size_t SimpleLRU::ItemMemory(const std::string &key, const std::string &value) {
+    return node_overhead() + string_memory(key.size()) + string_memory(value.size());
+}
+
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Put(const std::string &key, const std::string &value) {
-    if ((key.size() + value.size()) > _max_size)
+    if (ItemMemory(key, value) > _max_size)
         return false;
     mapT::iterator it = _lru_index.find(key);
     if (it != _lru_index.end())
@@ -16,9 +57,9 @@ bool SimpleLRU::Put(const std::string &key, const std::string &value) {
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::PutIfAbsent(const std::string &key, const std::string &value) {
-    if ((key.size() + value.size()) > _max_size)
+    if (ItemMemory(key, value) > _max_size)
         return false;
-mapT::iterator it=_lru_index.find(key);
+    mapT::iterator it = _lru_index.find(key);
     if (it == _lru_index.end())
         return put_node(key, value);
     else
@@ -27,7 +68,7 @@ mapT::iterator it=_lru_index.find(key);
 
 // See MapBasedGlobalLockImpl.h
 bool SimpleLRU::Set(const std::string &key, const std::string &value) {
-    if ((key.size() + value.size()) > _max_size)
+    if (ItemMemory(key, value) > _max_size)
         return false;
     mapT::iterator it = _lru_index.find(key);
     if (it != _lru_index.end())
@@ -55,10 +96,24 @@ bool SimpleLRU::Get(const std::string &key, std::string &value) {
     return move_node_tail(it->second.get());
 }
 
+// See SimpleLRU.h
+void SimpleLRU::Stats(std::vector<std::pair<std::string, std::size_t>> &stats) const {
+    stats.emplace_back("curr_items", _lru_index.size());
+    stats.emplace_back("bytes", _current_size);
+    stats.emplace_back("memory", _current_memory);
+    stats.emplace_back("limit_maxbytes", _max_size);
+    stats.emplace_back("rss", current_rss());
+    stats.emplace_back("limit_maxrss", _max_rss);
+    stats.emplace_back("evictions", _evictions);
+    stats.emplace_back("rss_evictions", _rss_evictions);
+}
+
 bool SimpleLRU::put_node(const std::string &key, const std::string &value) {
-    while (_current_size + key.size() + value.size() > _max_size)
+    size_t memory = ItemMemory(key, value);
+    while (_current_memory + memory > _max_size) {
         remove_node(*_lru_head);
-    _current_size += key.size() + value.size();
+        _evictions++;
+    }
     auto new_node = std::make_unique<lru_node>(key, value);
     if (_lru_tail != nullptr) {
         new_node->prev = _lru_tail;
@@ -71,16 +126,27 @@ bool SimpleLRU::put_node(const std::string &key, const std::string &value) {
     }
 
     _lru_index.insert(std::make_pair(std::reference_wrapper< std::string>(_lru_tail->key), std::reference_wrapper<lru_node> (*_lru_tail)));
+    _current_size += key.size() + value.size();
+    _current_memory += node_memory(*_lru_tail);
+    check_rss();
     return true;
 }
 
 bool SimpleLRU::update_node(const mapT::iterator &it, const std::string &new_value) {
     lru_node &old_node = it->second.get();
     if (move_node_tail(old_node)) {
-        while (_current_size - old_node.value.size() + new_value.size() > _max_size)
+        size_t old_memory = node_memory(old_node);
+        size_t new_memory = ItemMemory(old_node.key, new_value);
+        while (_current_memory - old_memory + new_memory > _max_size) {
             remove_node(*_lru_head);
+            _evictions++;
+        }
+
+        // Fresh copy doesn't inherit capacity of the old value, so estimation above stays exact
         _current_size += new_value.size() - old_node.value.size();
-        old_node.value = new_value;
+        _current_memory += new_memory - old_memory;
+        std::string(new_value).swap(old_node.value);
+        check_rss();
         return true;
     } else
         return false;
@@ -104,12 +170,17 @@ bool SimpleLRU::move_node_tail(lru_node &_node) {
 
 bool SimpleLRU::remove_node(lru_node &delete_node) {
     _lru_index.erase(delete_node.key);
-    _current_size -= ((_lru_tail->key).size() + (_lru_tail->value).size());
+    _current_size -= delete_node.key.size() + delete_node.value.size();
+    _current_memory -= node_memory(delete_node);
     std::unique_ptr<lru_node> tmp;
     if (&delete_node == _lru_head.get()) {
         tmp.swap(_lru_head);
         _lru_head.swap(tmp->next);
-        _lru_head->prev = nullptr;
+        if (_lru_head) {
+            _lru_head->prev = nullptr;
+        } else {
+            _lru_tail = nullptr;
+        }
         return true;
     } else if (&delete_node == _lru_tail) {
         tmp.swap(_lru_tail->prev->next);
@@ -122,5 +193,49 @@ bool SimpleLRU::remove_node(lru_node &delete_node) {
     tmp->next->prev = tmp->prev;
     return true;
 }
+
+size_t SimpleLRU::node_overhead() {
+    // Tree node holds color and three links in front of the value
+    const size_t map_node = 4 * sizeof(void *) + sizeof(mapT::value_type);
+    return malloc_size(sizeof(lru_node)) + malloc_size(map_node);
+}
+
+size_t SimpleLRU::node_memory(const lru_node &node) const {
+    return node_overhead() + string_memory(node.key.capacity()) + string_memory(node.value.capacity());
+}
+
+void SimpleLRU::check_rss() {
+    if (_max_rss == 0 || ++_writes < kRssCheckInterval) {
+        return;
+    }
+    _writes = 0;
+
+    size_t rss = current_rss();
+    if (rss <= _max_rss) {
+        _rss_mark = 0;
+        return;
+    }
+
+    // Memory freed last time is reused by new items before RSS grows again, so dropping more while RSS
+    // stays below the mark would only drain the cache
+    if (rss <= _rss_mark) {
+        return;
+    }
+
+    // Estimation is off, most likely because of fragmentation. Drop as much as RSS exceeds the limit or
+    // has grown since the last time, but keep the item just written
+    size_t excess = rss - std::max(_max_rss, _rss_mark), released = 0;
+    while (released < excess && _lru_head.get() != _lru_tail) {
+        released += node_memory(*_lru_head);
+        remove_node(*_lru_head);
+        _rss_evictions++;
+    }
+
+    // Whatever trim gives back is refaulted by the next writes without any growth of the cache, so it is
+    // measured after
+    malloc_trim(0);
+    _rss_mark = current_rss();
+}
+
 } // namespace Backend
 } // namespace Afina
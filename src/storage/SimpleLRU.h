@@ -7,6 +7,7 @@
 #include <mutex>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <afina/Storage.h>
 
@@ -15,11 +16,26 @@ namespace Backend {
 
 /**
  * # Map based implementation
+ * Capacity is measured in bytes of heap memory taken by the items: list node, index node, heap
+ * buffers of both strings, everything rounded up the way malloc does. Number of bytes in keys and
+ * values is tracked as well, but only reported.
+ *
+ * Estimation can't see allocator fragmentation, so optionally cache also checks process RSS once in
+ * a while and drops least recently used items if it is above the given limit. Freed memory is rarely
+ * given back to the system, so once items are dropped cache waits for RSS to grow past the level left
+ * after that and drops only that growth.
+ *
  * That is NOT thread safe implementaiton!!
  */
 class SimpleLRU : public Afina::Storage {
 public:
-    SimpleLRU(size_t max_size = 1024) : _max_size(max_size), _current_size(0), _lru_head(nullptr), _lru_tail(nullptr) {}
+    /**
+     * @param max_size memory budget for all items, in bytes
+     * @param max_rss process RSS at which cache starts evicting regardless of budget, 0 to disable
+     */
+    SimpleLRU(size_t max_size = 1024, size_t max_rss = 0)
+        : _max_size(max_size), _current_size(0), _current_memory(0), _max_rss(max_rss), _rss_mark(0), _writes(0),
+          _evictions(0), _rss_evictions(0), _lru_head(nullptr), _lru_tail(nullptr) {}
 
     ~SimpleLRU() {
         if (_lru_head) {
@@ -48,6 +64,24 @@ public:
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) override;
 
+    // Implements Afina::Storage interface
+    void Stats(std::vector<std::pair<std::string, std::size_t>> &stats) const override;
+
+    /**
+     * Heap memory taken by the item with given key and value once it is stored in cache
+     */
+    static size_t ItemMemory(const std::string &key, const std::string &value);
+
+    /**
+     * Bytes in all keys and values
+     */
+    size_t size() const { return _current_size; }
+
+    /**
+     * Heap memory taken by all items
+     */
+    size_t memory() const { return _current_memory; }
+
 private:
     // LRU cache node
     using lru_node = struct lru_node {
@@ -60,8 +94,14 @@ private:
     using mapT = std::map<std::reference_wrapper<const std::string>, std::reference_wrapper<lru_node>,
                           std::less<const std::string>>;
     // Maximum number of bytes could be stored in this cache.
-    // i.e all (keys+values) must be less the _max_size
-    std::size_t _max_size, _current_size;
+    // i.e memory of all items must be less the _max_size
+    std::size_t _max_size, _current_size, _current_memory;
+
+    // RSS safety valve, checked every kRssCheckInterval writes. Mark is RSS right after items were last
+    // dropped, 0 if RSS has been under the limit since then
+    std::size_t _max_rss, _rss_mark, _writes;
+
+    std::size_t _evictions, _rss_evictions;
 
     // Main storage of lru_nodes, elements in this list ordered descending by "freshness": in the head
     // element that wasn't used for longest time.
@@ -76,6 +116,9 @@ private:
     bool update_node(const mapT::iterator &it, const std::string &value);
     bool remove_node(lru_node &delete_node);
     bool move_node_tail(lru_node &node);
+    static size_t node_overhead();
+    size_t node_memory(const lru_node &node) const;
+    void check_rss();
 };
 } // namespace Backend
 } // namespace Afina
@@ -17,7 +17,7 @@ namespace Backend {
  */
 class ThreadSafeSimplLRU : public SimpleLRU {
 public:
-    ThreadSafeSimplLRU(size_t max_size = 1024) : SimpleLRU(max_size) {}
+    ThreadSafeSimplLRU(size_t max_size = 1024, size_t max_rss = 0) : SimpleLRU(max_size, max_rss) {}
     ~ThreadSafeSimplLRU() {}
 
     // see SimpleLRU.h
@@ -50,6 +50,12 @@ public:
         return SimpleLRU::Get(key, value);
     }
 
+    // see SimpleLRU.h
+    void Stats(std::vector<std::pair<std::string, std::size_t>> &stats) const override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        SimpleLRU::Stats(stats);
+    }
+
 private:
     mutable std::mutex _mutex;
 };
@@ -0,0 +1,561 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cxxopts.hpp>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Simple.h>
+#include <afina/allocator/Slab.h>
+
+using namespace Afina::Allocator;
+
+/**
+ * # Allocator benchmark
+ * Replays alloc/free/realloc traces against each allocator and reports throughput, tail latency,
+ * peak RSS and fragmentation (bytes held by allocator per byte requested by alive objects, measured
+ * at the end of the trace). Each case runs in a separate process so that peak RSS isn't shared
+ */
+namespace {
+
+struct Op {
+    enum Type : char { Alloc = 'a', Free = 'f', Realloc = 'r' };
+
+    Type type;
+    uint32_t id;
+    uint32_t size;
+};
+
+/**
+ * Allocator under test, objects are referenced by trace ids
+ */
+class Subject {
+public:
+    virtual ~Subject() {}
+
+    // Returns false if allocator is out of memory
+    virtual bool alloc(uint32_t id, size_t size) = 0;
+    virtual bool realloc(uint32_t id, size_t size) = 0;
+    virtual void free(uint32_t id) = 0;
+
+    // Called once bookkeeping of the benchmark itself is allocated
+    virtual void start() {}
+
+    // Bytes allocator holds to serve alive objects
+    virtual size_t footprint() = 0;
+};
+
+inline void touch(void *p, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    char *v = static_cast<char *>(p);
+    v[0] = 1;
+    v[size - 1] = 1;
+}
+
+class Malloc : public Subject {
+public:
+    Malloc(size_t ids) : _ptrs(ids, nullptr) {}
+    ~Malloc() {
+        for (void *p : _ptrs) {
+            std::free(p);
+        }
+    }
+
+    bool alloc(uint32_t id, size_t size) override {
+        _ptrs[id] = std::malloc(size);
+        touch(_ptrs[id], size);
+        return true;
+    }
+
+    bool realloc(uint32_t id, size_t size) override {
+        _ptrs[id] = std::realloc(_ptrs[id], size);
+        touch(_ptrs[id], size);
+        return true;
+    }
+
+    void free(uint32_t id) override {
+        std::free(_ptrs[id]);
+        _ptrs[id] = nullptr;
+    }
+
+    void start() override { _baseline = held(); }
+
+    size_t footprint() override { return held() - _baseline; }
+
+private:
+    static size_t held() {
+        struct mallinfo2 mi = mallinfo2();
+        return mi.uordblks + mi.hblkhd;
+    }
+
+    std::vector<void *> _ptrs;
+    size_t _baseline = 0;
+};
+
+class SimpleSubject : public Subject {
+public:
+    SimpleSubject(size_t ids, size_t area) : _area(new char[area]), _allocator(_area.get(), area), _ptrs(ids) {}
+
+    bool alloc(uint32_t id, size_t size) override {
+        try {
+            _ptrs[id] = _allocator.alloc(size);
+        } catch (AllocError &) {
+            // That is what owner is expected to do once allocator is fragmented
+            _allocator.defrag();
+            try {
+                _ptrs[id] = _allocator.alloc(size);
+            } catch (AllocError &) {
+                return false;
+            }
+        }
+        touch(_ptrs[id].get(), size);
+        return true;
+    }
+
+    bool realloc(uint32_t id, size_t size) override {
+        try {
+            _allocator.realloc(_ptrs[id], size);
+        } catch (AllocError &) {
+            return false;
+        }
+        touch(_ptrs[id].get(), size);
+        return true;
+    }
+
+    void free(uint32_t id) override { _allocator.free(_ptrs[id]); }
+
+    size_t footprint() override { return _allocator.used() + _allocator.fragmented(); }
+
+private:
+    std::unique_ptr<char[]> _area;
+    Simple _allocator;
+    std::vector<Pointer> _ptrs;
+};
+
+class SlabSubject : public Subject {
+public:
+    SlabSubject(size_t ids, size_t area)
+        : _area(new char[area]), _allocator(_area.get(), area), _ptrs(ids, nullptr), _sizes(ids, 0) {}
+
+    bool alloc(uint32_t id, size_t size) override {
+        _ptrs[id] = _allocator.alloc(size);
+        if (_ptrs[id] == nullptr) {
+            return false;
+        }
+        _sizes[id] = size;
+        touch(_ptrs[id], size);
+        return true;
+    }
+
+    bool realloc(uint32_t id, size_t size) override {
+        void *p = _allocator.alloc(size);
+        if (p == nullptr) {
+            return false;
+        }
+        std::memcpy(p, _ptrs[id], std::min(size, _sizes[id]));
+        _allocator.free(_ptrs[id]);
+        _ptrs[id] = p;
+        _sizes[id] = size;
+        touch(p, size);
+        return true;
+    }
+
+    void free(uint32_t id) override {
+        _allocator.free(_ptrs[id]);
+        _ptrs[id] = nullptr;
+    }
+
+    size_t footprint() override {
+        size_t result = 0;
+        for (auto &c : _allocator.stats()) {
+            result += (c.used + c.free) * c.chunk_size;
+        }
+        return result;
+    }
+
+private:
+    std::unique_ptr<char[]> _area;
+    Slab _allocator;
+    std::vector<void *> _ptrs;
+    std::vector<size_t> _sizes;
+};
+
+std::unique_ptr<Subject> make_subject(const std::string &name, size_t ids, size_t area) {
+    if (name == "malloc") {
+        return std::unique_ptr<Subject>(new Malloc(ids));
+    } else if (name == "simple") {
+        return std::unique_ptr<Subject>(new SimpleSubject(ids, area));
+    } else if (name == "slab") {
+        return std::unique_ptr<Subject>(new SlabSubject(ids, area));
+    }
+    throw std::runtime_error("Unknown allocator: " + name);
+}
+
+/**
+ * Synthetic trace: keeps up to `live` objects alive, each step either allocates an empty slot or
+ * frees/reallocates an occupied one
+ */
+template <typename Sizes> std::vector<Op> synthetic(size_t ops, size_t live, unsigned seed, Sizes sizes) {
+    std::mt19937 rnd(seed);
+    std::uniform_int_distribution<uint32_t> slot(0, live - 1);
+    std::uniform_int_distribution<int> action(0, 9);
+    std::vector<bool> used(live, false);
+
+    std::vector<Op> trace;
+    trace.reserve(ops);
+    while (trace.size() < ops) {
+        uint32_t id = slot(rnd);
+        if (!used[id]) {
+            trace.push_back(Op{Op::Alloc, id, sizes(rnd)});
+            used[id] = true;
+        } else if (action(rnd) == 0) {
+            trace.push_back(Op{Op::Realloc, id, sizes(rnd)});
+        } else {
+            trace.push_back(Op{Op::Free, id, 0});
+            used[id] = false;
+        }
+    }
+    return trace;
+}
+
+std::vector<Op> make_trace(const std::string &name, size_t ops, size_t live, unsigned seed) {
+    if (name == "uniform") {
+        std::uniform_int_distribution<uint32_t> d(16, 4096);
+        return synthetic(ops, live, seed, [&](std::mt19937 &rnd) { return d(rnd); });
+    } else if (name == "bimodal") {
+        std::uniform_int_distribution<uint32_t> small(16, 128), large(2048, 8192);
+        std::bernoulli_distribution is_large(0.1);
+        return synthetic(ops, live, seed,
+                         [&](std::mt19937 &rnd) { return is_large(rnd) ? large(rnd) : small(rnd); });
+    } else if (name == "powerlaw") {
+        // Pareto with alpha = 1.2 starting from 16 bytes, capped by the largest slab class
+        std::uniform_real_distribution<double> u(0, 1);
+        return synthetic(ops, live, seed, [&](std::mt19937 &rnd) {
+            return uint32_t(std::min(16 * std::pow(1 - u(rnd), -1 / 1.2), 65536.0));
+        });
+    }
+    throw std::runtime_error("Unknown trace: " + name);
+}
+
+/**
+ * Recorded trace, one operation per line: "a <id> <size>", "r <id> <size>" or "f <id>". Allocations of
+ * 0 bytes are skipped: replay tells alive objects by their size, such object would never be freed
+ */
+std::vector<Op> load_trace(const std::string &path, size_t &ids) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Failed to open trace " + path);
+    }
+
+    std::vector<Op> trace;
+    char type;
+    uint32_t id, size;
+    size_t skipped = 0;
+    ids = 0;
+    while (in >> type >> id) {
+        size = 0;
+        if (type != Op::Free) {
+            in >> size;
+            if (size == 0) {
+                skipped++;
+                continue;
+            }
+        }
+        trace.push_back(Op{Op::Type(type), id, size});
+        ids = std::max<size_t>(ids, id + 1);
+    }
+
+    if (skipped > 0) {
+        std::fprintf(stderr, "Skipped %zu records of 0 bytes in %s\n", skipped, path.c_str());
+    }
+    return trace;
+}
+
+struct Result {
+    size_t ops;
+    size_t failures;
+    double seconds;
+    std::vector<uint32_t> latency;
+    size_t footprint;
+    size_t requested;
+};
+
+// Replays trace in the current thread
+Result replay(Subject &subject, const std::vector<Op> &trace, size_t ids) {
+    Result r{0, 0, 0, {}, 0, 0};
+    r.latency.reserve(trace.size());
+
+    std::vector<uint32_t> sizes(ids, 0);
+    subject.start();
+    auto begin = std::chrono::steady_clock::now();
+    for (const Op &op : trace) {
+        // Recorded trace could miss a free, object still alive under the same id would leak otherwise
+        if (op.type == Op::Alloc && sizes[op.id] > 0) {
+            subject.free(op.id);
+            sizes[op.id] = 0;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = true;
+        switch (op.type) {
+        case Op::Alloc:
+            if ((ok = subject.alloc(op.id, op.size))) {
+                sizes[op.id] = op.size;
+            }
+            break;
+        case Op::Realloc:
+            if (sizes[op.id] > 0 && (ok = subject.realloc(op.id, op.size))) {
+                sizes[op.id] = op.size;
+            }
+            break;
+        case Op::Free:
+            if (sizes[op.id] > 0) {
+                subject.free(op.id);
+                sizes[op.id] = 0;
+            }
+            break;
+        }
+        auto end = std::chrono::steady_clock::now();
+        r.latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        r.failures += ok ? 0 : 1;
+    }
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    r.ops = trace.size();
+
+    for (uint32_t s : sizes) {
+        r.requested += s;
+    }
+    r.footprint = subject.footprint();
+    return r;
+}
+
+// Producer thread allocates objects and hands them to consumer which frees them. Allocators that
+// aren't threadsafe are guarded by a single lock
+Result producer_consumer(Subject &subject, bool threadsafe, size_t ops, size_t live, unsigned seed) {
+    Result r{0, 0, 0, {}, 0, 0};
+    std::mutex lock, queue_lock;
+    std::condition_variable not_empty, not_full;
+    std::deque<uint32_t> queue, free_ids;
+    for (uint32_t i = 0; i < live; i++) {
+        free_ids.push_back(i);
+    }
+
+    std::vector<uint32_t> produce_latency, consume_latency;
+    produce_latency.reserve(ops / 2);
+    consume_latency.reserve(ops / 2);
+    const size_t items = ops / 2;
+
+    auto timed = [&](std::vector<uint32_t> &latency, std::function<bool()> f) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok;
+        if (threadsafe) {
+            ok = f();
+        } else {
+            std::lock_guard<std::mutex> guard(lock);
+            ok = f();
+        }
+        auto end = std::chrono::steady_clock::now();
+        latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        return ok;
+    };
+
+    size_t failures = 0;
+    subject.start();
+    auto begin = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        std::mt19937 rnd(seed);
+        std::uniform_int_distribution<uint32_t> d(16, 1024);
+        for (size_t i = 0; i < items; i++) {
+            uint32_t id;
+            {
+                std::unique_lock<std::mutex> guard(queue_lock);
+                not_full.wait(guard, [&] { return !free_ids.empty(); });
+                id = free_ids.front();
+                free_ids.pop_front();
+            }
+
+            uint32_t size = d(rnd);
+            if (!timed(produce_latency, [&] { return subject.alloc(id, size); })) {
+                failures++;
+                std::unique_lock<std::mutex> guard(queue_lock);
+                free_ids.push_back(id);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> guard(queue_lock);
+            queue.push_back(id);
+            not_empty.notify_one();
+        }
+
+        std::unique_lock<std::mutex> guard(queue_lock);
+        queue.push_back(uint32_t(-1));
+        not_empty.notify_one();
+    });
+
+    std::thread consumer([&]() {
+        for (;;) {
+            uint32_t id;
+            {
+                std::unique_lock<std::mutex> guard(queue_lock);
+                not_empty.wait(guard, [&] { return !queue.empty(); });
+                id = queue.front();
+                queue.pop_front();
+            }
+            if (id == uint32_t(-1)) {
+                break;
+            }
+
+            timed(consume_latency, [&] {
+                subject.free(id);
+                return true;
+            });
+
+            std::unique_lock<std::mutex> guard(queue_lock);
+            free_ids.push_back(id);
+            not_full.notify_one();
+        }
+    });
+
+    producer.join();
+    consumer.join();
+    r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    r.ops = produce_latency.size() + consume_latency.size();
+    r.failures = failures;
+    r.latency = std::move(produce_latency);
+    r.latency.insert(r.latency.end(), consume_latency.begin(), consume_latency.end());
+    r.footprint = subject.footprint();
+    return r;
+}
+
+void report(const std::string &allocator, const std::string &trace, Result &r) {
+    uint32_t p99 = 0;
+    if (!r.latency.empty()) {
+        auto nth = r.latency.begin() + r.latency.size() * 99 / 100;
+        std::nth_element(r.latency.begin(), nth, r.latency.end());
+        p99 = *nth;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    char frag[32] = "-";
+    if (r.requested > 0) {
+        std::snprintf(frag, sizeof(frag), "%.3f", double(r.footprint) / r.requested);
+    }
+
+    std::printf("%-8s %-10s %12.0f %10u %12ld %8s %10zu\n", allocator.c_str(), trace.c_str(), r.ops / r.seconds, p99,
+                usage.ru_maxrss, frag, r.failures);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("runAllocatorBenchmark", "Allocators performance and fragmentation benchmark");
+    options.add_options()("a,allocators", "Comma separated allocators: malloc, simple, slab",
+                          cxxopts::value<std::string>()->default_value("malloc,simple,slab"));
+    options.add_options()("t,traces", "Comma separated traces: uniform, bimodal, powerlaw, prodcons",
+                          cxxopts::value<std::string>()->default_value("uniform,bimodal,powerlaw,prodcons"));
+    options.add_options()("f,file", "Recorded trace to replay instead of synthetic ones",
+                          cxxopts::value<std::string>());
+    options.add_options()("o,ops", "Operations per trace", cxxopts::value<size_t>()->default_value("1000000"));
+    options.add_options()("l,live", "Maximum number of alive objects", cxxopts::value<size_t>()->default_value("10000"));
+    options.add_options()("m,memory", "Area size in MB for allocators managing fixed area",
+                          cxxopts::value<size_t>()->default_value("256"));
+    options.add_options()("s,seed", "Random seed", cxxopts::value<unsigned>()->default_value("42"));
+    options.add_options()("h,help", "Print usage info");
+    options.parse(argc, argv);
+
+    if (options.count("help") > 0) {
+        std::cerr << options.help() << std::endl;
+        return 0;
+    }
+
+    auto split = [](const std::string &s) {
+        std::vector<std::string> result;
+        size_t pos = 0, next;
+        while ((next = s.find(',', pos)) != std::string::npos) {
+            result.push_back(s.substr(pos, next - pos));
+            pos = next + 1;
+        }
+        result.push_back(s.substr(pos));
+        return result;
+    };
+
+    size_t ops = options["ops"].as<size_t>();
+    size_t live = options["live"].as<size_t>();
+    size_t area = options["memory"].as<size_t>() << 20;
+    unsigned seed = options["seed"].as<unsigned>();
+
+    std::vector<std::string> traces = split(options["traces"].as<std::string>());
+    if (options.count("file") > 0) {
+        traces = {options["file"].as<std::string>()};
+    }
+
+    std::printf("%-8s %-10s %12s %10s %12s %8s %10s\n", "alloc", "trace", "ops/sec", "p99(ns)", "peak_rss(KB)",
+                "frag", "failures");
+    std::fflush(stdout);
+    for (const std::string &trace : traces) {
+        for (const std::string &allocator : split(options["allocators"].as<std::string>())) {
+            pid_t pid = fork();
+            if (pid == -1) {
+                std::perror("fork");
+                return 1;
+            }
+
+            if (pid > 0) {
+                int status;
+                waitpid(pid, &status, 0);
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                    std::fprintf(stderr, "%s on %s failed\n", allocator.c_str(), trace.c_str());
+                }
+                continue;
+            }
+
+            try {
+                Result r;
+                if (trace == "prodcons") {
+                    auto subject = make_subject(allocator, live, area);
+                    r = producer_consumer(*subject, allocator == "malloc", ops, live, seed);
+                } else if (options.count("file") > 0) {
+                    size_t ids;
+                    std::vector<Op> ops_list = load_trace(trace, ids);
+                    auto subject = make_subject(allocator, ids, area);
+                    r = replay(*subject, ops_list, ids);
+                } else {
+                    std::vector<Op> ops_list = make_trace(trace, ops, live, seed);
+                    auto subject = make_subject(allocator, live, area);
+                    r = replay(*subject, ops_list, live);
+                }
+                report(allocator, trace, r);
+            } catch (std::exception &e) {
+                std::fprintf(stderr, "Error: %s\n", e.what());
+                _exit(1);
+            }
+            _exit(0);
+        }
+    }
+    return 0;
+}
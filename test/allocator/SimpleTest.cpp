@@ -1,8 +1,12 @@
 #include "gtest/gtest.h"
+#include <chrono>
 #include <iostream>
+#include <mutex>
 #include <set>
+#include <thread>
 #include <vector>
 
+#include <afina/allocator/Defragmenter.h>
 #include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 #include <afina/allocator/Simple.h>
@@ -322,3 +326,73 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, DefragIncremental) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> ptrs;
+    int size = 135;
+
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+    for (int i = 30; i > 0; i -= 3) {
+        a.free(ptrs[i]);
+        ptrs.erase(ptrs.begin() + i);
+    }
+    EXPECT_GT(a.fragmented(), 0);
+
+    // Each step moves a single block, data must stay consistent in between
+    int steps = 0;
+    while (a.defrag_step(1)) {
+        steps++;
+        for (Pointer &p : ptrs) {
+            ASSERT_TRUE(isDataOk(p, size));
+        }
+    }
+
+    EXPECT_GT(steps, 1);
+    EXPECT_EQ(a.fragmented(), 0);
+
+    Pointer newPtr = a.alloc(size * 5);
+    writeTo(newPtr, size * 5);
+
+    for (Pointer &p : ptrs) {
+        EXPECT_TRUE(isDataOk(p, size));
+        a.free(p);
+    }
+}
+
+TEST(SimpleTest, DefragBackground) {
+    Simple a(buf, sizeof(buf));
+    std::mutex lock;
+
+    vector<Pointer> ptrs;
+    int size = 135;
+
+    ASSERT_TRUE(fillUp(a, size, ptrs));
+    for (int i = 30; i > 0; i -= 3) {
+        a.free(ptrs[i]);
+        ptrs.erase(ptrs.begin() + i);
+    }
+
+    Defragmenter defrag(a, lock, std::chrono::microseconds(50), std::chrono::microseconds(100));
+    defrag.Start();
+    for (int i = 0; i < 1000; i++) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (Pointer &p : ptrs) {
+                ASSERT_TRUE(isDataOk(p, size));
+            }
+            if (a.fragmented() == 0) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    defrag.Stop();
+
+    EXPECT_EQ(a.fragmented(), 0);
+    for (Pointer &p : ptrs) {
+        EXPECT_TRUE(isDataOk(p, size));
+        a.free(p);
+    }
+}
@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Rebalancer.h>
+#include <afina/allocator/Slab.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+static char slab_buf[16 * 4096];
+
+TEST(SlabTest, AllocInRange) {
+    Slab a(slab_buf, sizeof(slab_buf), 4096);
+
+    set<void *> seen;
+    for (int i = 0; i < 100; i++) {
+        char *v = static_cast<char *>(a.alloc(100));
+        ASSERT_NE(v, nullptr);
+        EXPECT_GE(v, slab_buf);
+        EXPECT_LE(v + 100, slab_buf + sizeof(slab_buf));
+        EXPECT_TRUE(seen.insert(v).second);
+    }
+
+    for (void *p : seen) {
+        a.free(p);
+    }
+}
+
+TEST(SlabTest, ClassOf) {
+    Slab a(slab_buf, sizeof(slab_buf), 4096, 64, 2);
+
+    EXPECT_EQ(a.class_of(1), 0);
+    EXPECT_EQ(a.class_of(64), 0);
+    EXPECT_EQ(a.class_of(65), 1);
+    EXPECT_EQ(a.stats()[a.class_of(4096)].chunk_size, 4096);
+    EXPECT_THROW(a.alloc(4097), AllocError);
+}
+
+TEST(SlabTest, ReuseAfterFree) {
+    Slab a(slab_buf, sizeof(slab_buf), 4096);
+
+    vector<void *> ptrs;
+    void *p;
+    while ((p = a.alloc(200)) != nullptr) {
+        ptrs.push_back(p);
+    }
+
+    size_t cls = a.class_of(200);
+    EXPECT_EQ(a.stats()[cls].evictions, 1);
+    EXPECT_EQ(a.stats()[cls].pages, 16);
+
+    a.free(ptrs[5]);
+    EXPECT_EQ(a.alloc(200), ptrs[5]);
+
+    for (void *p : ptrs) {
+        a.free(p);
+    }
+    EXPECT_EQ(a.stats()[cls].used, 0);
+}
+
+TEST(SlabTest, AutomoveFeedsStarvingClass) {
+    Slab a(slab_buf, sizeof(slab_buf), 4096);
+
+    // Fill everything with small chunks
+    vector<void *> small;
+    void *p;
+    while ((p = a.alloc(100)) != nullptr) {
+        small.push_back(p);
+    }
+
+    set<void *> alive(small.begin(), small.end());
+    a.set_evictor([&](void *chunk) {
+        alive.erase(chunk);
+        a.free(chunk);
+    });
+
+    // Forget the failure that ended filling, then large values can't get memory
+    // until their class starves for 3 rounds in a row
+    EXPECT_FALSE(a.automove(3));
+    size_t big = a.class_of(1000);
+    vector<void *> large;
+    for (int round = 0; round < 3; round++) {
+        EXPECT_EQ(a.alloc(1000), nullptr);
+        EXPECT_EQ(a.automove(3), round == 2);
+    }
+
+    EXPECT_EQ(a.moves(), 1);
+    EXPECT_EQ(a.stats()[big].pages, 1);
+    EXPECT_LT(alive.size(), small.size());
+
+    while ((p = a.alloc(1000)) != nullptr) {
+        large.push_back(p);
+    }
+    EXPECT_EQ(large.size(), 4096 / a.stats()[big].chunk_size);
+
+    for (void *p : large) {
+        a.free(p);
+    }
+    for (void *p : alive) {
+        a.free(p);
+    }
+}
+
+TEST(SlabTest, RebalancerBackground) {
+    Slab a(slab_buf, sizeof(slab_buf), 4096);
+    std::mutex lock;
+
+    vector<void *> small;
+    void *p;
+    while ((p = a.alloc(100)) != nullptr) {
+        small.push_back(p);
+    }
+    for (void *p : small) {
+        a.free(p);
+    }
+
+    Rebalancer rebalancer(a, lock, std::chrono::milliseconds(1), 1);
+    rebalancer.Start();
+
+    void *large = nullptr;
+    for (int i = 0; i < 1000 && large == nullptr; i++) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            large = a.alloc(1000);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    rebalancer.Stop();
+
+    ASSERT_NE(large, nullptr);
+    a.free(large);
+}
@@ -0,0 +1,120 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <afina/concurrency/Executor.h>
+
+using namespace Afina::Concurrency;
+
+// Blocks tasks until released, so test controls how many threads are busy
+class Gate {
+public:
+    Gate() : _open(false), _waiting(0) {}
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _waiting++;
+        _changed.notify_all();
+        _changed.wait(lock, [this]() { return _open; });
+        _waiting--;
+    }
+
+    void AwaitWaiting(int n) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _changed.wait(lock, [this, n]() { return _waiting >= n; });
+    }
+
+    void Open() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _open = true;
+        _changed.notify_all();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _changed;
+    bool _open;
+    int _waiting;
+};
+
+TEST(ExecutorTest, ExecutesTasks) {
+    Executor executor("test", 16, 4, 2);
+    executor.Start();
+
+    std::atomic<int> sum(0);
+    for (int i = 1; i <= 100; i++) {
+        while (!executor.Execute([&sum](int v) { sum += v; }, i)) {
+            std::this_thread::yield();
+        }
+    }
+    executor.Stop(true);
+
+    EXPECT_EQ(5050, sum.load());
+}
+
+TEST(ExecutorTest, RejectsBeforeStartAndAfterStop) {
+    Executor executor("test", 4);
+    EXPECT_FALSE(executor.Execute([]() {}));
+
+    executor.Start();
+    EXPECT_TRUE(executor.Execute([]() {}));
+    executor.Stop(true);
+
+    EXPECT_FALSE(executor.Execute([]() {}));
+}
+
+TEST(ExecutorTest, GrowsUpToHighWatermark) {
+    Executor executor("test", 0, 3, 1);
+    executor.Start();
+
+    // Each task holds a thread, all three must run at once
+    Gate gate;
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(executor.Execute([&gate]() { gate.Wait(); }));
+    }
+    gate.AwaitWaiting(3);
+
+    // No free thread and no queue
+    EXPECT_FALSE(executor.Execute([]() {}));
+
+    gate.Open();
+    executor.Stop(true);
+}
+
+TEST(ExecutorTest, QueueIsBounded) {
+    Executor executor("test", 2, 1, 1);
+    executor.Start();
+
+    Gate gate;
+    ASSERT_TRUE(executor.Execute([&gate]() { gate.Wait(); }));
+    gate.AwaitWaiting(1);
+
+    std::atomic<int> done(0);
+    EXPECT_TRUE(executor.Execute([&done]() { done++; }));
+    EXPECT_TRUE(executor.Execute([&done]() { done++; }));
+    EXPECT_FALSE(executor.Execute([&done]() { done++; }));
+
+    // Queued tasks are completed on stop
+    gate.Open();
+    executor.Stop(true);
+    EXPECT_EQ(2, done.load());
+}
+
+TEST(ExecutorTest, SurvivesThrowingTask) {
+    Executor executor("test", 4, 1, 1);
+    executor.Start();
+
+    std::atomic<bool> done(false);
+    ASSERT_TRUE(executor.Execute([]() { throw std::runtime_error("task failed"); }));
+    while (!executor.Execute([&done]() { done = true; })) {
+        std::this_thread::yield();
+    }
+    executor.Stop(true);
+
+    EXPECT_TRUE(done.load());
+}
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <network/common/MpscQueue.h>
+
+using namespace Afina::Network;
+
+TEST(MpscQueueTest, EmptyAndFull) {
+    MpscQueue<int> queue(4);
+    int value = -1;
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_EQ(0u, queue.size());
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.push(i));
+    }
+    EXPECT_EQ(4u, queue.size());
+    EXPECT_FALSE(queue.push(4));
+
+    // Popped cell is free for the next lap
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(0, value);
+    EXPECT_TRUE(queue.push(4));
+    EXPECT_FALSE(queue.push(5));
+
+    for (int i = 1; i <= 4; i++) {
+        ASSERT_TRUE(queue.pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_EQ(0u, queue.size());
+}
+
+TEST(MpscQueueTest, ManyLaps) {
+    MpscQueue<int> queue(8);
+    int next = 0, expected = 0, value;
+    for (int lap = 0; lap < 1000; lap++) {
+        while (queue.push(next)) {
+            next++;
+        }
+        EXPECT_EQ(8u, queue.size());
+
+        for (int i = 0; i < 5; i++) {
+            ASSERT_TRUE(queue.pop(value));
+            ASSERT_EQ(expected++, value);
+        }
+    }
+
+    while (queue.pop(value)) {
+        ASSERT_EQ(expected++, value);
+    }
+    EXPECT_EQ(next, expected);
+}
+
+TEST(MpscQueueTest, MultipleProducers) {
+    const uint64_t producers = 4;
+    const uint64_t per_producer = 100000;
+    MpscQueue<uint64_t> queue(64);
+
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p, per_producer]() {
+            for (uint64_t i = 0; i < per_producer; i++) {
+                // Small ring is full most of the time, so producers keep racing each other for cells
+                while (!queue.push(p * per_producer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Every value is seen exactly once, values of each producer come in order they were pushed
+    std::vector<bool> seen(producers * per_producer, false);
+    std::vector<uint64_t> next(producers, 0);
+    for (uint64_t received = 0; received < producers * per_producer;) {
+        uint64_t value;
+        if (!queue.pop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        ASSERT_LT(value, seen.size());
+        ASSERT_FALSE(seen[value]) << "duplicate " << value;
+        seen[value] = true;
+
+        uint64_t p = value / per_producer;
+        ASSERT_EQ(next[p], value % per_producer) << "producer " << p;
+        next[p]++;
+        received++;
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    uint64_t value;
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_EQ(0u, queue.size());
+}
@@ -0,0 +1,189 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+
+#include <network/common/InputBuffer.h>
+
+using namespace Afina::Network;
+
+namespace {
+
+// Small blocks, so a few dozen bytes already make a chain
+const std::size_t kBlock = 64;
+
+std::string Pattern(std::size_t size) {
+    std::string result;
+    for (std::size_t i = 0; i < size; i++) {
+        result.push_back('a' + i % 26);
+    }
+    return result;
+}
+
+// Copies data in, prepare() by prepare()
+void Fill(InputBuffer &buffer, const std::string &data) {
+    std::size_t done = 0;
+    while (done < data.size()) {
+        std::size_t size;
+        char *dst = buffer.prepare(size);
+        EXPECT_GT(size, 0u);
+        size = std::min(size, data.size() - done);
+        std::memcpy(dst, data.data() + done, size);
+        buffer.commit(size);
+        done += size;
+    }
+}
+
+// Takes n bytes out, peek() by peek()
+std::string Drain(InputBuffer &buffer, std::size_t n) {
+    std::string result;
+    while (result.size() < n) {
+        std::size_t size;
+        const char *src = buffer.peek(size);
+        EXPECT_NE(nullptr, src);
+        EXPECT_GT(size, 0u);
+        size = std::min(size, n - result.size());
+        result.append(src, size);
+        buffer.consume(size);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(InputBufferTest, Empty) {
+    ChunkPool pool(kBlock);
+    InputBuffer buffer(pool);
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(0u, buffer.size());
+
+    std::size_t size = 1;
+    EXPECT_EQ(nullptr, buffer.peek(size));
+    EXPECT_EQ(0u, size);
+}
+
+TEST(InputBufferTest, PrepareContinuesBlock) {
+    ChunkPool pool(kBlock);
+    InputBuffer buffer(pool);
+
+    std::size_t size;
+    char *first = buffer.prepare(size);
+    ASSERT_GT(size, 10u);
+    std::size_t capacity = size;
+    std::memcpy(first, "0123456789", 10);
+
+    // Nothing is visible till commit
+    EXPECT_TRUE(buffer.empty());
+    buffer.commit(10);
+    EXPECT_EQ(10u, buffer.size());
+
+    char *second = buffer.prepare(size);
+    EXPECT_EQ(first + 10, second);
+    EXPECT_EQ(capacity - 10, size);
+
+    const char *data = buffer.peek(size);
+    EXPECT_EQ(first, data);
+    EXPECT_EQ("0123456789", std::string(data, size));
+}
+
+TEST(InputBufferTest, ChainBlocks) {
+    ChunkPool pool(kBlock);
+    InputBuffer buffer(pool);
+
+    std::string data = Pattern(1000);
+    std::set<char *> blocks;
+    std::size_t done = 0;
+    while (done < data.size()) {
+        std::size_t size;
+        char *dst = buffer.prepare(size);
+        ASSERT_LT(size, kBlock);
+        blocks.insert(dst);
+        size = std::min(size, data.size() - done);
+        std::memcpy(dst, data.data() + done, size);
+        buffer.commit(size);
+        done += size;
+    }
+    EXPECT_GT(blocks.size(), 1000 / kBlock);
+    EXPECT_EQ(data.size(), buffer.size());
+
+    // Peek never crosses block boundary
+    std::size_t size;
+    buffer.peek(size);
+    EXPECT_LT(size, kBlock);
+
+    EXPECT_EQ(data, Drain(buffer, data.size()));
+    EXPECT_TRUE(buffer.empty());
+}
+
+TEST(InputBufferTest, ConsumeAcrossBlocks) {
+    ChunkPool pool(kBlock);
+    InputBuffer buffer(pool);
+
+    std::string data = Pattern(300);
+    Fill(buffer, data);
+
+    std::size_t first;
+    buffer.peek(first);
+    ASSERT_LT(first, 100u);
+
+    // Drop whole first block and part of the second one at once
+    buffer.consume(first + 5);
+    EXPECT_EQ(data.size() - first - 5, buffer.size());
+
+    std::size_t size;
+    const char *rest = buffer.peek(size);
+    EXPECT_EQ(first - 5, size);
+    EXPECT_EQ(data.substr(first + 5, size), std::string(rest, size));
+
+    EXPECT_EQ(data.substr(first + 5), Drain(buffer, buffer.size()));
+}
+
+TEST(InputBufferTest, ReuseBlocks) {
+    ChunkPool pool(kBlock);
+    InputBuffer buffer(pool);
+
+    std::set<char *> blocks;
+    for (int i = 0; i < 4; i++) {
+        std::size_t size;
+        char *dst = buffer.prepare(size);
+        blocks.insert(dst);
+        std::memset(dst, 'x', size);
+        buffer.commit(size);
+    }
+    ASSERT_EQ(4u, blocks.size());
+
+    // Drained buffer holds nothing, next read lands into one of released blocks
+    buffer.consume(buffer.size());
+    EXPECT_TRUE(buffer.empty());
+    std::size_t size;
+    EXPECT_EQ(1u, blocks.count(buffer.prepare(size)));
+
+    buffer.commit(1);
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(1u, blocks.count(buffer.prepare(size)));
+}
+
+TEST(InputBufferTest, Interleave) {
+    ChunkPool pool(kBlock);
+    InputBuffer buffer(pool);
+    std::mt19937 rnd(7);
+
+    // Socket reads and command parsing come in arbitrary portions, bytes must come out in order anyway
+    std::string data = Pattern(100000);
+    std::size_t written = 0, read = 0;
+    while (read < data.size()) {
+        std::size_t n = std::min<std::size_t>(rnd() % 200, data.size() - written);
+        Fill(buffer, data.substr(written, n));
+        written += n;
+        ASSERT_EQ(written - read, buffer.size());
+
+        n = std::min<std::size_t>(rnd() % 200, buffer.size());
+        ASSERT_EQ(data.substr(read, n), Drain(buffer, n));
+        read += n;
+        ASSERT_EQ(written - read, buffer.size());
+    }
+    EXPECT_TRUE(buffer.empty());
+}
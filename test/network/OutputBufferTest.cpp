@@ -0,0 +1,165 @@
+#include "gtest/gtest.h"
+
+#include <cerrno>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <network/common/OutputBuffer.h>
+
+using namespace Afina::Network;
+
+namespace {
+
+std::string Pattern(std::size_t size) {
+    std::string result;
+    for (std::size_t i = 0; i < size; i++) {
+        result.push_back('a' + i % 26);
+    }
+    return result;
+}
+
+// Nonblocking pair of connected sockets standing for the client
+class OutputBufferTest : public ::testing::Test {
+protected:
+    void SetUp() override { ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, _fds)); }
+
+    void TearDown() override {
+        close(_fds[0]);
+        close(_fds[1]);
+    }
+
+    int server() const { return _fds[0]; }
+
+    // Everything client could read right now
+    std::string Receive() {
+        std::string result;
+        char buf[4096];
+        ssize_t n;
+        while ((n = read(_fds[1], buf, sizeof(buf))) > 0) {
+            result.append(buf, n);
+        }
+        return result;
+    }
+
+private:
+    int _fds[2];
+};
+
+} // namespace
+
+TEST_F(OutputBufferTest, Empty) {
+    ChunkPool pool(64);
+    OutputBuffer buffer(pool);
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(0, buffer.write(server()));
+    EXPECT_EQ("", Receive());
+}
+
+TEST_F(OutputBufferTest, WriteChain) {
+    ChunkPool pool(64);
+    OutputBuffer buffer(pool);
+
+    // Pieces of different size so they straddle block boundaries
+    std::string data = Pattern(1000);
+    std::size_t done = 0;
+    for (std::size_t piece = 1; done < data.size(); piece += 3) {
+        piece = std::min(piece, data.size() - done);
+        buffer.append(data.data() + done, piece);
+        done += piece;
+        EXPECT_EQ(done, buffer.size());
+    }
+
+    EXPECT_EQ(ssize_t(data.size()), buffer.write(server()));
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(data, Receive());
+}
+
+TEST_F(OutputBufferTest, LongChain) {
+    ChunkPool pool(64);
+    OutputBuffer buffer(pool);
+
+    // More blocks than single writev takes, rest stays queued
+    std::string data = Pattern(20000);
+    buffer.append(data);
+
+    ssize_t written = buffer.write(server());
+    ASSERT_GT(written, 0);
+    ASSERT_LT(written, ssize_t(data.size()));
+    EXPECT_EQ(data.size() - written, buffer.size());
+
+    std::string received = Receive();
+    while (!buffer.empty()) {
+        ASSERT_GT(buffer.write(server()), 0);
+        received += Receive();
+    }
+    EXPECT_EQ(data, received);
+}
+
+TEST_F(OutputBufferTest, PartialWrite) {
+    ChunkPool pool;
+    OutputBuffer buffer(pool);
+
+    // Much more than socket buffer takes
+    std::string data = Pattern(8 << 20);
+    buffer.append(data);
+
+    std::string received;
+    while (!buffer.empty()) {
+        std::size_t before = buffer.size();
+        ssize_t written = buffer.write(server());
+        ASSERT_GT(written, 0);
+        EXPECT_EQ(before - written, buffer.size());
+
+        if (!buffer.empty()) {
+            // Socket is full, failed write leaves data queued
+            errno = 0;
+            while ((written = buffer.write(server())) > 0) {
+            }
+            EXPECT_EQ(-1, written);
+            EXPECT_EQ(EAGAIN, errno);
+            std::size_t queued = buffer.size();
+
+            received += Receive();
+            ASSERT_EQ(data.substr(0, data.size() - queued), received);
+        }
+    }
+    received += Receive();
+    EXPECT_EQ(data, received);
+}
+
+TEST_F(OutputBufferTest, AppendAfterPartialWrite) {
+    ChunkPool pool(64);
+    OutputBuffer buffer(pool);
+
+    std::string head = Pattern(20000);
+    buffer.append(head);
+    ssize_t written = buffer.write(server());
+    ASSERT_GT(written, 0);
+
+    // New response goes after what is still queued
+    std::string tail = "VALUE foo 0 3\r\nbar\r\nEND\r\n";
+    buffer.append(tail);
+    EXPECT_EQ(head.size() + tail.size() - written, buffer.size());
+
+    std::string received = Receive();
+    while (!buffer.empty()) {
+        ASSERT_GT(buffer.write(server()), 0);
+        received += Receive();
+    }
+    EXPECT_EQ(head + tail, received);
+}
+
+TEST_F(OutputBufferTest, Clear) {
+    ChunkPool pool(64);
+    OutputBuffer buffer(pool);
+    buffer.append(Pattern(1000));
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(0, buffer.write(server()));
+
+    buffer.append("END\r\n");
+    EXPECT_EQ(5, buffer.write(server()));
+    EXPECT_EQ("END\r\n", Receive());
+}
@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <network/common/ChunkPool.h>
+#include <network/common/ObjectPool.h>
+
+using namespace Afina::Network;
+
+namespace {
+
+// Counts live instances
+struct Tracked {
+    explicit Tracked(int v, bool fail = false) : value(v) {
+        if (fail) {
+            throw std::runtime_error("construction failed");
+        }
+        live++;
+    }
+    ~Tracked() { live--; }
+
+    static int live;
+
+    int value;
+    char payload[100];
+};
+
+int Tracked::live = 0;
+
+} // namespace
+
+TEST(ChunkPoolTest, ReuseBlock) {
+    ChunkPool pool(256);
+    EXPECT_EQ(256u, pool.block_size());
+
+    void *a = pool.get();
+    void *b = pool.get();
+    EXPECT_NE(a, b);
+
+    // Released block is the first one to be taken again
+    pool.put(a);
+    EXPECT_EQ(a, pool.get());
+
+    pool.put(a);
+    pool.put(b);
+    EXPECT_EQ(b, pool.get());
+    EXPECT_EQ(a, pool.get());
+
+    pool.put(a);
+    pool.put(b);
+}
+
+TEST(ChunkPoolTest, MaxFree) {
+    ChunkPool pool(256, 2);
+
+    std::vector<void *> blocks;
+    for (int i = 0; i < 4; i++) {
+        blocks.push_back(pool.get());
+    }
+    for (void *b : blocks) {
+        pool.put(b);
+    }
+
+    // Only two blocks stay in the pool, the rest went back to the heap
+    void *x = pool.get();
+    void *y = pool.get();
+    EXPECT_EQ(blocks[1], x);
+    EXPECT_EQ(blocks[0], y);
+    pool.put(x);
+    pool.put(y);
+}
+
+TEST(ObjectPoolTest, MakeDestroy) {
+    ObjectPool<Tracked> pool(4);
+    Tracked *a = pool.make(1);
+    Tracked *b = pool.make(2);
+    EXPECT_EQ(2u, pool.size());
+    EXPECT_EQ(2, Tracked::live);
+    EXPECT_EQ(1, a->value);
+    EXPECT_EQ(2, b->value);
+
+    pool.destroy(a);
+    EXPECT_EQ(1u, pool.size());
+    EXPECT_EQ(1, Tracked::live);
+    EXPECT_EQ(2, b->value);
+
+    pool.destroy(b);
+    EXPECT_EQ(0u, pool.size());
+    EXPECT_EQ(0, Tracked::live);
+}
+
+TEST(ObjectPoolTest, ReuseSlot) {
+    ObjectPool<Tracked> pool(4);
+    Tracked *a = pool.make(1);
+    Tracked *b = pool.make(2);
+
+    pool.destroy(a);
+    Tracked *c = pool.make(3);
+    EXPECT_EQ(a, c);
+    EXPECT_EQ(3, c->value);
+    EXPECT_EQ(2, b->value);
+
+    pool.destroy(b);
+    pool.destroy(c);
+}
+
+TEST(ObjectPoolTest, Grow) {
+    ObjectPool<Tracked> pool(4);
+
+    // Several slabs, every object keeps its own slot
+    std::vector<Tracked *> objects;
+    std::set<Tracked *> slots;
+    for (int i = 0; i < 50; i++) {
+        objects.push_back(pool.make(i));
+        slots.insert(objects.back());
+        objects.back()->payload[0] = char(i);
+    }
+    EXPECT_EQ(50u, slots.size());
+    EXPECT_EQ(50u, pool.size());
+    for (int i = 0; i < 50; i++) {
+        EXPECT_EQ(i, objects[i]->value);
+        EXPECT_EQ(char(i), objects[i]->payload[0]);
+    }
+
+    // Churn after the peak takes no new slots
+    for (int i = 0; i < 50; i += 2) {
+        pool.destroy(objects[i]);
+    }
+    for (int i = 0; i < 50; i += 2) {
+        objects[i] = pool.make(i);
+        EXPECT_EQ(1u, slots.count(objects[i]));
+    }
+
+    for (Tracked *t : objects) {
+        pool.destroy(t);
+    }
+    EXPECT_EQ(0u, pool.size());
+    EXPECT_EQ(0, Tracked::live);
+}
+
+TEST(ObjectPoolTest, ConstructorThrows) {
+    ObjectPool<Tracked> pool(4);
+    Tracked *a = pool.make(1);
+    pool.destroy(a);
+
+    // Slot of failed object goes back to the free list
+    EXPECT_THROW(pool.make(2, true), std::runtime_error);
+    EXPECT_EQ(0u, pool.size());
+    EXPECT_EQ(0, Tracked::live);
+
+    Tracked *b = pool.make(3);
+    EXPECT_EQ(a, b);
+    pool.destroy(b);
+}
@@ -0,0 +1,226 @@
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <network/common/TimerWheel.h>
+
+using namespace Afina::Network;
+
+namespace {
+
+// Timer remembering when it has fired
+struct Probe {
+    Probe() : fired(0), at(0) { timer.data = this; }
+
+    TimerWheel::Timer timer;
+    int fired;
+    uint64_t at;
+};
+
+void Advance(TimerWheel &wheel, uint64_t now) {
+    wheel.advance(now, [now](TimerWheel::Timer *t) {
+        Probe *p = static_cast<Probe *>(t->data);
+        p->fired++;
+        p->at = now;
+    });
+}
+
+} // namespace
+
+TEST(TimerWheelTest, FireOnExpiration) {
+    TimerWheel wheel(0, 1);
+    Probe p;
+    wheel.schedule(&p.timer, 10);
+    EXPECT_TRUE(p.timer.armed());
+    EXPECT_EQ(1u, wheel.size());
+
+    Advance(wheel, 9);
+    EXPECT_EQ(0, p.fired);
+
+    Advance(wheel, 10);
+    EXPECT_EQ(1, p.fired);
+    EXPECT_FALSE(p.timer.armed());
+    EXPECT_EQ(0u, wheel.size());
+
+    Advance(wheel, 1000);
+    EXPECT_EQ(1, p.fired);
+}
+
+TEST(TimerWheelTest, RoundUpToTick) {
+    TimerWheel wheel(0, 8);
+    Probe p;
+    wheel.schedule(&p.timer, 20);
+
+    Advance(wheel, 23);
+    EXPECT_EQ(0, p.fired);
+    Advance(wheel, 24);
+    EXPECT_EQ(1, p.fired);
+}
+
+TEST(TimerWheelTest, ExpireAcrossLevels) {
+    // Boundaries of the first, second and third levels on both sides
+    const uint64_t start = 1000;
+    std::vector<uint64_t> delays = {1, 63, 64, 65, 127, 128, 4095, 4096, 4097, 5000, 262143, 262144, 262145, 300000};
+    TimerWheel wheel(start, 1);
+    std::vector<Probe> probes(delays.size());
+    for (std::size_t i = 0; i < delays.size(); i++) {
+        wheel.schedule(&probes[i].timer, start + delays[i]);
+    }
+
+    for (uint64_t now = start + 1; now <= start + delays.back(); now++) {
+        Advance(wheel, now);
+    }
+    for (std::size_t i = 0; i < delays.size(); i++) {
+        EXPECT_EQ(1, probes[i].fired) << "delay " << delays[i];
+        EXPECT_EQ(start + delays[i], probes[i].at) << "delay " << delays[i];
+    }
+    EXPECT_EQ(0u, wheel.size());
+}
+
+TEST(TimerWheelTest, ExpireInOrderOnLongAdvance) {
+    TimerWheel wheel(0, 1);
+    std::vector<uint64_t> expires = {70000, 5, 4100, 64, 300, 262200};
+    std::vector<Probe> probes(expires.size());
+    for (std::size_t i = 0; i < expires.size(); i++) {
+        wheel.schedule(&probes[i].timer, expires[i]);
+    }
+
+    std::vector<uint64_t> order;
+    wheel.advance(1000000, [&order](TimerWheel::Timer *t) { order.push_back(t->expires); });
+    ASSERT_EQ(expires.size(), order.size());
+    for (std::size_t i = 1; i < order.size(); i++) {
+        EXPECT_LT(order[i - 1], order[i]);
+    }
+}
+
+TEST(TimerWheelTest, RandomNeverEarlyNeverLate) {
+    std::mt19937 rnd(42);
+    const uint64_t start = 123457;
+    TimerWheel wheel(start, 1);
+    std::vector<Probe> probes(1000);
+    std::vector<uint64_t> expires(probes.size());
+    for (std::size_t i = 0; i < probes.size(); i++) {
+        expires[i] = start + 1 + rnd() % 100000;
+        wheel.schedule(&probes[i].timer, expires[i]);
+    }
+
+    // Timer must fire on the first advance reaching its expiration, whatever steps event loop makes
+    uint64_t prev = start;
+    while (wheel.size() > 0) {
+        uint64_t now = prev + 1 + rnd() % 500;
+        Advance(wheel, now);
+        for (std::size_t i = 0; i < probes.size(); i++) {
+            if (expires[i] > prev && expires[i] <= now) {
+                ASSERT_EQ(1, probes[i].fired) << "expires " << expires[i] << " advanced to " << now;
+            } else if (expires[i] > now) {
+                ASSERT_EQ(0, probes[i].fired) << "expires " << expires[i] << " advanced to " << now;
+            }
+        }
+        prev = now;
+    }
+}
+
+TEST(TimerWheelTest, Reschedule) {
+    TimerWheel wheel(0, 1);
+    Probe p;
+    wheel.schedule(&p.timer, 100);
+
+    // Earlier
+    wheel.schedule(&p.timer, 50);
+    EXPECT_EQ(1u, wheel.size());
+    Advance(wheel, 50);
+    EXPECT_EQ(1, p.fired);
+    EXPECT_EQ(50u, p.at);
+    Advance(wheel, 100);
+    EXPECT_EQ(1, p.fired);
+
+    // Later, across levels
+    wheel.schedule(&p.timer, 150);
+    wheel.schedule(&p.timer, 5000);
+    EXPECT_EQ(1u, wheel.size());
+    Advance(wheel, 4999);
+    EXPECT_EQ(1, p.fired);
+    Advance(wheel, 5000);
+    EXPECT_EQ(2, p.fired);
+    EXPECT_EQ(5000u, p.at);
+}
+
+TEST(TimerWheelTest, RescheduleFromCallback) {
+    TimerWheel wheel(0, 1);
+    Probe p;
+    wheel.schedule(&p.timer, 10);
+
+    // Periodic timer
+    for (uint64_t now = 1; now <= 100; now++) {
+        wheel.advance(now, [&wheel, &p, now](TimerWheel::Timer *t) {
+            p.fired++;
+            wheel.schedule(t, now + 10);
+        });
+    }
+    EXPECT_EQ(10, p.fired);
+    EXPECT_EQ(1u, wheel.size());
+}
+
+TEST(TimerWheelTest, Cancel) {
+    TimerWheel wheel(0, 1);
+    Probe p, q;
+    wheel.schedule(&p.timer, 10);
+    wheel.schedule(&q.timer, 5000);
+
+    wheel.cancel(&p.timer);
+    wheel.cancel(&q.timer);
+    EXPECT_FALSE(p.timer.armed());
+    EXPECT_FALSE(q.timer.armed());
+    EXPECT_EQ(0u, wheel.size());
+
+    // Cancelling disarmed timer does nothing
+    wheel.cancel(&p.timer);
+    EXPECT_EQ(0u, wheel.size());
+
+    Advance(wheel, 10000);
+    EXPECT_EQ(0, p.fired);
+    EXPECT_EQ(0, q.fired);
+}
+
+TEST(TimerWheelTest, Timeout) {
+    TimerWheel wheel(0, 8);
+    EXPECT_EQ(-1, wheel.timeout(0));
+
+    Probe p;
+    wheel.schedule(&p.timer, 20);
+    EXPECT_EQ(24, wheel.timeout(0));
+    EXPECT_EQ(14, wheel.timeout(10));
+
+    // Overdue wheel needs advance right away
+    EXPECT_EQ(0, wheel.timeout(30));
+
+    wheel.cancel(&p.timer);
+    EXPECT_EQ(-1, wheel.timeout(0));
+}
+
+TEST(TimerWheelTest, TimeoutDrivenLoop) {
+    // Event loop sleeping exactly as long as the wheel asks must not miss the timer, while waking up
+    // at most once per turn of the lowest level to cascade upper ones
+    for (uint64_t delay : {5, 64, 100, 4096, 10000, 300000}) {
+        const uint64_t start = 777;
+        TimerWheel wheel(start, 1);
+        Probe p;
+        wheel.schedule(&p.timer, start + delay);
+
+        uint64_t now = start;
+        uint64_t wakeups = 0;
+        while (p.fired == 0) {
+            int timeout = wheel.timeout(now);
+            ASSERT_GT(timeout, 0) << "delay " << delay;
+            ASSERT_LE(now + timeout, start + delay) << "delay " << delay;
+            now += timeout;
+            Advance(wheel, now);
+            wakeups++;
+        }
+        EXPECT_EQ(start + delay, p.at) << "delay " << delay;
+        EXPECT_LE(wakeups, delay / 64 + 2) << "delay " << delay;
+        EXPECT_EQ(-1, wheel.timeout(now));
+    }
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 
 #include <afina/execute/Add.h>
@@ -81,6 +82,30 @@ TEST(MemcachedParserTest, SimpleGet) {
     ASSERT_EQ("super_long_key", keys[2]);
 }
 
+// Keys of previous command are kept by parser for reuse, they must not leak into the next one
+TEST(MemcachedParserTest, GetAfterLongerGet) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    size_t value_size;
+    ASSERT_TRUE(parser.Parse("get first_long_key_here b c\r\n", consumed));
+    ASSERT_FALSE(parser.Build(value_size) == nullptr);
+    parser.Reset();
+
+    ASSERT_TRUE(parser.Parse("get d\r\n", consumed));
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd.get());
+    ASSERT_EQ(1, tmp->keys().size());
+    ASSERT_EQ("d", tmp->keys()[0]);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set k 0 0 1\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_EQ("k", reinterpret_cast<Execute::Set *>(cmd.get())->key());
+}
+
 TEST(MemcachedParserTest, Stats) {
     Protocol::Parser parser;
 
@@ -98,3 +123,77 @@ TEST(MemcachedParserTest, Stats) {
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
     ASSERT_FALSE(tmp == nullptr);
 }
+
+// Verify command could be placed into parser itself, one after another
+TEST(MemcachedParserTest, BuildInPlace) {
+    Protocol::Parser parser;
+
+    for (int i = 0; i < 3; i++) {
+        size_t consumed = 0;
+        bool cmd_avail = parser.Parse("set foo 0 0 6\r\nfooval\r\n", consumed);
+        ASSERT_TRUE(cmd_avail);
+
+        size_t value_size;
+        Protocol::InPlaceCommand cmd = parser.BuildInPlace(value_size);
+        ASSERT_FALSE(cmd == nullptr);
+        ASSERT_EQ(6, value_size);
+
+        Execute::Set *tmp = reinterpret_cast<Execute::Set *>(cmd.get());
+        ASSERT_EQ("foo", tmp->key());
+
+        cmd.reset();
+        parser.Reset();
+    }
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("get a bb ccc\r\n", consumed));
+    size_t value_size;
+    Protocol::InPlaceCommand cmd = parser.BuildInPlace(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    std::vector<std::string> keys = reinterpret_cast<Execute::Get *>(cmd.get())->keys();
+    ASSERT_EQ(3, keys.size());
+    ASSERT_EQ("ccc", keys[2]);
+}
+
+// Data block is read together with its terminator, which is not a part of the value
+TEST(MemcachedParserTest, DataBlock) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    size_t value_size;
+    ASSERT_TRUE(parser.Parse("set foo 0 0 6\r\n", consumed));
+    ASSERT_FALSE(parser.Build(value_size) == nullptr);
+    ASSERT_EQ(8, parser.BlockSize());
+
+    std::string block = "fooval\r\n";
+    parser.StripBlock(block);
+    ASSERT_EQ("fooval", block);
+
+    block = "foovalxx";
+    ASSERT_THROW(parser.StripBlock(block), std::runtime_error);
+    block = "fooval\r\nx";
+    ASSERT_THROW(parser.StripBlock(block), std::runtime_error);
+
+    // Empty value still has the terminator
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set foo 0 0 0\r\n", consumed));
+    ASSERT_FALSE(parser.Build(value_size) == nullptr);
+    ASSERT_EQ(0, value_size);
+    ASSERT_EQ(2, parser.BlockSize());
+    block = "\r\n";
+    parser.StripBlock(block);
+    ASSERT_EQ("", block);
+
+    // Commands without data block
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("get foo\r\n", consumed));
+    ASSERT_EQ(0, parser.BlockSize());
+    block.clear();
+    parser.StripBlock(block);
+    ASSERT_EQ("", block);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("stats\r\n", consumed));
+    ASSERT_EQ(0, parser.BlockSize());
+}
@@ -1,9 +1,14 @@
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <set>
 #include <vector>
 
+#include <malloc.h>
+#include <unistd.h>
+
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Delete.h>
@@ -147,7 +152,7 @@ std::string pad_space(const std::string &s, size_t length) {
 
 TEST(StorageTest, BigTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 100000 * length);
+    SimpleLRU storage(100000 * SimpleLRU::ItemMemory(pad_space("Key", length), pad_space("Val", length)));
 
     for (long i = 0; i < 100000; ++i) {
         auto key = pad_space("Key " + std::to_string(i), length);
@@ -168,7 +173,7 @@ TEST(StorageTest, BigTest) {
 
 TEST(StorageTest, MaxTest) {
     const size_t length = 20;
-    SimpleLRU storage(2 * 1000 * length);
+    SimpleLRU storage(1000 * SimpleLRU::ItemMemory(pad_space("Key", length), pad_space("Val", length)));
 
     std::stringstream ss;
 
@@ -195,3 +200,58 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+TEST(StorageTest, MemoryAccounting) {
+    const size_t length = 100;
+    SimpleLRU storage(1024 * 1024);
+
+    auto key = pad_space("Key", length);
+    auto val = pad_space("Val", length);
+    EXPECT_TRUE(storage.Put(key, val));
+    EXPECT_EQ(storage.size(), 2 * length);
+    EXPECT_EQ(storage.memory(), SimpleLRU::ItemMemory(key, val));
+    EXPECT_GT(storage.memory(), storage.size());
+
+    EXPECT_TRUE(storage.Set(key, "short"));
+    EXPECT_EQ(storage.size(), length + 5);
+    EXPECT_EQ(storage.memory(), SimpleLRU::ItemMemory(key, "short"));
+
+    EXPECT_TRUE(storage.Delete(key));
+    EXPECT_EQ(storage.size(), 0);
+    EXPECT_EQ(storage.memory(), 0);
+
+    // Item doesn't fit only because of its overhead
+    SimpleLRU small(2 * length);
+    EXPECT_FALSE(small.Put(key, pad_space("", length)));
+}
+
+TEST(StorageTest, RssLimit) {
+    const size_t length = 1024, limit = 8 * 1024 * 1024, count = 32 * 1024;
+
+    // Limit is relative to what test process already has, without memory freed by previous tests
+    malloc_trim(0);
+    size_t pages = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    ASSERT_TRUE(statm >> pages >> resident);
+    SimpleLRU storage(1024 * 1024 * 1024, resident * sysconf(_SC_PAGESIZE) + limit);
+
+    for (size_t i = 0; i < count; ++i) {
+        auto key = pad_space("Key " + std::to_string(i), length);
+        auto val = pad_space("Val " + std::to_string(i), length);
+        EXPECT_TRUE(storage.Put(key, val));
+    }
+
+    std::string res;
+    EXPECT_TRUE(storage.Get(pad_space("Key " + std::to_string(count - 1), length), res));
+    EXPECT_FALSE(storage.Get(pad_space("Key 0", length), res));
+
+    // Cache is kept around the limit rather than drained on every check once it is reached
+    std::vector<std::pair<std::string, size_t>> stats;
+    storage.Stats(stats);
+    auto rss_evictions = std::find_if(stats.begin(), stats.end(), [](auto &s) { return s.first == "rss_evictions"; });
+    ASSERT_TRUE(rss_evictions != stats.end());
+    EXPECT_GT(rss_evictions->second, 0u);
+    EXPECT_EQ(rss_evictions->second + storage.size() / (2 * length), count);
+    EXPECT_GT(storage.memory(), limit / 2);
+    EXPECT_LT(storage.memory(), 2 * limit);
+}